@@ -6,15 +6,26 @@
 /// 实现 AlgorithmImplBase
 /////////////////////////////////////
 
+int AlgorithmImplBase::Update(Blackboard &b) {
+  StepUsage used;
+  return Step(b, {1, 0}, used);
+}
+
 void AlgorithmImplBase::setupBlackboard(Blackboard &b) {
   // 清理黑板
   b.isStopped = false;
-  memset(b.visited, 0, sizeof(b.visited));
-  for (int i = 0; i < M; i++)
-    for (int j = 0; j < N; j++) b.exploring[i][j] = -1;
+  b.expansions = 0;
+  b.stale_pops = 0;
+  // 尺寸不变时, Resize 是 O(1) 的, 不会遍历整个地图
+  resizeState(b.visited, false);
+  resizeState(b.exploring, -1);
   // 默认情况下, 都不支持流场 (除了流场寻路)
   b.isSupportedFlowField = false;
+  b.flows = nullptr;
   b.path.clear();
+  // 整个黑板都变了, 需要全部重绘
+  b.dirty.clear();
+  b.dirty_all = true;
 }
 
 /////////////////////////////////////
@@ -22,27 +33,14 @@ void AlgorithmImplBase::setupBlackboard(Blackboard &b) {
 /////////////////////////////////////
 
 void AlgorithmImplGraphBase::setupEdges(bool use_4directions) {
-  memset(from, 0x3f, sizeof(from));
-  // 构造 edges
-  edges.clear();
-  edges.resize(n);
+  resizeState(from, inf);
   // 4 方向是取前 4 个.
-  int K = use_4directions ? 4 : 8;
-  for (int i = 0; i < M; i++) {
-    for (int j = 0; j < N; j++) {
-      if (GRID_MAP[i][j])  // 不可从障碍物出发
-        continue;
-      int x = pack(i, j);
-      // 都可以走, 除非是有障碍物
-      for (int k = 0; k < K; k++) {
-        const auto &[w, d] = DIRECTIONS[k];
-        auto i1 = i + d.first, j1 = j + d.second;
-        // 不可到达障碍物, 不可越过边界
-        if (ValidatePoint(i1, j1) && !GRID_MAP[i1][j1])
-          edges[x].push_back({w, pack(i1, j1)});
-      }
-    }
+  direction_mask = use_4directions ? 0x0f : 0xff;
+  for (int k = 0; k < 8; k++) {
+    const auto &[_, d] = DIRECTIONS[k];
+    offsets[k] = pack(d.first, d.second);
   }
+  GRID_MAP.PrepareNeighborMasks();
 }
 
 void AlgorithmImplGraphBase::buildShortestPathResult(Blackboard &b) {
@@ -60,3 +58,61 @@ void AlgorithmImplGraphBase::buildShortestPathResult(Blackboard &b) {
   }
   b.isStopped = true;
 }
+
+/////////////////////////////////////
+/// 实现 AlgorithmImplIncrementalBase
+/////////////////////////////////////
+
+void AlgorithmImplIncrementalBase::setupGraph(bool use_4directions) {
+  pred.clear();
+  succ.clear();
+  pred.resize(GRID_MAP.Size());
+  succ.resize(GRID_MAP.Size());
+  // 初始化 pred 和 succ
+  for (int i = 0; i < GRID_MAP.Rows(); i++) {
+    for (int j = 0; j < GRID_MAP.Cols(); j++) {
+      int x = pack(i, j);
+      int di_max = use_4directions ? 4 : 8;
+      for (int di = 0; di < di_max; di++) {
+        const auto &[w, d] = DIRECTIONS[di];
+        auto i1 = i + d.first, j1 = j + d.second;
+        auto y = pack(i1, j1);
+        if (ValidatePoint(i1, j1)) {
+          // 现在考虑的边 (x => y)
+          // 后继
+          succ[x].push_back(y);
+          // 前继, 从障碍物出发或者到达障碍物都算作无穷大的边权
+          pred[y].push_back(
+              {x, (GRID_MAP.Get(i, j) || GRID_MAP.Get(i1, j1)) ? inf : w});
+        }
+      }
+    }
+  }
+}
+
+void AlgorithmImplIncrementalBase::blockEdges(int x) {
+  // 到达 x 的边权全部无穷大
+  for (auto &[y, w] : pred[x]) w = inf;
+  // x 到达后继邻居的边权全部无穷大
+  for (auto y : succ[x])
+    for (auto &[x1, w] : pred[y])
+      if (x1 == x) w = inf;
+}
+
+// 边 (x, y) 的原始边权, 斜边还是水平竖直边
+static int edgeCost(int x, int y) {
+  int di = unpack_i(x) - unpack_i(y), dj = unpack_j(x) - unpack_j(y);
+  return (di != 0 && dj != 0) ? DIAGONAL_COST : COST_UNIT;
+}
+
+void AlgorithmImplIncrementalBase::restoreEdges(int x) {
+  // 到达 x 的边权恢复, 另一端仍然是障碍物的保持无穷大
+  for (auto &[y, w] : pred[x])
+    w = GRID_MAP.Get(unpack_i(y), unpack_j(y)) ? inf : edgeCost(x, y);
+  // x 到达后继邻居的边权恢复
+  for (auto y : succ[x]) {
+    if (GRID_MAP.Get(unpack_i(y), unpack_j(y))) continue;
+    for (auto &[x1, w] : pred[y])
+      if (x1 == x) w = edgeCost(x, y);
+  }
+}
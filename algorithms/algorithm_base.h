@@ -1,8 +1,27 @@
 #ifndef PATH_FINDING_VISUALIZER_ALGORITHM_H
 #define PATH_FINDING_VISUALIZER_ALGORITHM_H
 
+#include <bit>
+#include <chrono>
+#include <type_traits>
+#include <vector>
+
 #include "../base.h"
 
+// 一次 Step 的预算: 最多走的步数 (一步是一次 Update 的工作量,
+// 通常是扩展一个节点) 和最长的时间 (微秒), 0 表示这一项不限制.
+// 两项都是 0 时一直执行到结束
+struct StepBudget {
+  int nodes = 0;
+  int time_us = 0;
+};
+
+// 一次 Step 实际消耗的步数和时间
+struct StepUsage {
+  int nodes = 0;
+  double time_us = 0;
+};
+
 // 算法实现的虚类
 class Algorithm {
  public:
@@ -13,6 +32,11 @@ class Algorithm {
   // 如果已经结束, 则返回 0, 没结束返回 -1, 失败返回 -2
   // 在结束返回 0 的时候必须要保证 blackboard 上的最短路结果 path 被填写.
   virtual int Update(Blackboard &b) = 0;
+  // 在预算内连续地走多步, 结果和连续调用同样次数的 Update 相同,
+  // 但循环在算法内部, 循环外的状态只加载一次 (比如游戏的每一帧限时寻路).
+  // 返回值和 Update 相同, 预算用完时返回 -1. 实际消耗写到 used
+  virtual int Step(Blackboard &b, const StepBudget &budget,
+                   StepUsage &used) = 0;
   // 处理地图变化 (目前就是新增和删除障碍物点)
   // 如果算法支持增量计算, 就直接增量重新规划路径
   // 否则就需要完全重新计算, 相当于 Setup 要重新执行一次
@@ -23,12 +47,56 @@ class Algorithm {
   // 处理起始点变化
   virtual void HandleStartPointChange(Blackboard &b,
                                       const Options &options) = 0;
+  // 是否支持分块存储的地图 (见 tile_store.h).
+  // 需要遍历整张地图的算法 (预处理, 显式建图, 流场) 不支持
+  virtual bool SupportsTiledMap(const Options & /*options*/) const {
+    return false;
+  }
   // makes unique_ptr happy
   virtual ~Algorithm() {}
 };
 
+// Step 的计量: 记录走过的步数和耗时, 判断预算是否用完
+class StepMeter {
+ public:
+  // 读时钟比扩展一个节点还慢, 所以每 time_check_interval 步才检查一次时间.
+  // 每一步的工作量很大的算法应该每一步都检查
+  StepMeter(const StepBudget &budget, StepUsage &used,
+            int time_check_interval = 16)
+      : budget(budget),
+        used(used),
+        interval(time_check_interval),
+        t0(std::chrono::steady_clock::now()) {
+    used = {};
+  }
+  ~StepMeter() { used.time_us = elapsed(); }
+  // 记一步, 预算用完时返回 false
+  bool Spend() {
+    used.nodes++;
+    if (budget.nodes > 0 && used.nodes >= budget.nodes) return false;
+    return budget.time_us <= 0 || used.nodes % interval != 0 ||
+           elapsed() < budget.time_us;
+  }
+
+ private:
+  const StepBudget &budget;
+  StepUsage &used;
+  int interval;
+  std::chrono::steady_clock::time_point t0;
+
+  double elapsed() const {
+    return std::chrono::duration<double, std::micro>(
+               std::chrono::steady_clock::now() - t0)
+        .count();
+  }
+};
+
 // 算法实现的基础类, 可选择性继承
 class AlgorithmImplBase : public Algorithm {
+ public:
+  // 走一步, 即预算为一步的 Step. 子类只需要实现 Step
+  int Update(Blackboard &b) override;
+
  protected:
   // (距离 OR 边权, 节点号)
   using P = std::pair<int, int>;
@@ -36,21 +104,108 @@ class AlgorithmImplBase : public Algorithm {
   int s, t;
   // 设置(清理) 黑板, 允许重复执行
   virtual void setupBlackboard(Blackboard &b);
+  // 按当前地图调整按标号存储的搜索状态的尺寸, 并清空为 value.
+  // 分块地图按分块分页存储, 只为搜索访问到的分块分配内存
+  template <typename T>
+  static void resizeState(StampedArray<T> &state,
+                          std::type_identity_t<T> value) {
+    if (auto *tiles = GRID_MAP.Tiles())
+      state.ResizePaged(GRID_MAP.Rows(), GRID_MAP.Cols(),
+                        std::countr_zero(unsigned(tiles->TileSize())), value);
+    else
+      state.Resize(GRID_MAP.Size(), value);
+  }
+  template <typename T>
+  static void resizeState(StampedGrid<T> &state,
+                          std::type_identity_t<T> value) {
+    if (auto *tiles = GRID_MAP.Tiles())
+      state.ResizePaged(GRID_MAP.Rows(), GRID_MAP.Cols(),
+                        std::countr_zero(unsigned(tiles->TileSize())), value);
+    else
+      state.Resize(GRID_MAP.Rows(), GRID_MAP.Cols(), value);
+  }
+};
+
+// 按方向位掩码遍历节点 x 的邻居, 每一项是 {边权, 邻接点}
+// 边权取自 DIRECTIONS, 不需要为每个节点存储邻接表
+class NeighborRange {
+ public:
+  class Iterator {
+   public:
+    Iterator(int x, unsigned mask, const int *offsets)
+        : x(x), mask(mask), offsets(offsets) {}
+    std::pair<int, int> operator*() const {
+      int k = std::countr_zero(mask);
+      return {DIRECTIONS[k].first, x + offsets[k]};
+    }
+    Iterator &operator++() {
+      mask &= mask - 1;  // 去掉最低位的方向
+      return *this;
+    }
+    bool operator!=(const Iterator &o) const { return mask != o.mask; }
+
+   private:
+    int x;
+    unsigned mask;
+    const int *offsets;
+  };
+
+  NeighborRange(int x, unsigned mask, const int *offsets)
+      : x(x), mask(mask), offsets(offsets) {}
+  Iterator begin() const { return {x, mask, offsets}; }
+  Iterator end() const { return {x, 0, offsets}; }
+
+ private:
+  int x;
+  unsigned mask;
+  const int *offsets;
 };
 
 // 基于图的寻路算法的基础类, 可选择性继承
+// 图是隐式的: 邻接关系来自地图的邻居位掩码 (见 GridMap::NeighborMask),
+// 地图变化时不需要重新建图.
 class AlgorithmImplGraphBase : public AlgorithmImplBase {
  protected:
-  // edges[x] => {{w, y}}, 每一项是: {边权, 邻接点}
-  std::vector<std::vector<P>> edges;
   // from[x] 保存 x 最短路的上一步由哪个节点而来
   // 默认是 inf, 如果最终算法结束仍然是 inf, 则表示算法失败
-  int from[n];
+  // 按标号存储, 每次寻路时的清理是 O(1) 的
+  StampedArray<int> from;
 
-  // 初始化建图, 允许重复执行
+  // 初始化图, 允许重复执行
+  // 邻居位掩码只在第一次时整体计算, 之后的调用是 O(1) 的
   virtual void setupEdges(bool use_4directions = false);
+  // 节点 x 的邻接边, 每一项是: {边权, 邻接点}
+  NeighborRange neighbors(int x) const {
+    return {x, GRID_MAP.NeighborMask(x) & direction_mask, offsets};
+  }
+
   // 从 from 数组反向收集最短路结果
   virtual void buildShortestPathResult(Blackboard &b);
+
+ private:
+  // 4 方向时只取前 4 个方向
+  unsigned direction_mask = 0xff;
+  // offsets[k] 是沿 DIRECTIONS[k] 走一步时标号的增量
+  int offsets[8];
+};
+
+// 增量寻路算法 (LPA*, D* Lite) 的基础类, 可选择性继承
+// 图是显式的: 每个节点保存前继和后继, 地图变化时只修改相关的边权.
+// 网格上的边总是双向的, 两个方向的边权也相同.
+class AlgorithmImplIncrementalBase : public AlgorithmImplBase {
+ protected:
+  // 前继 {标号, 边权}
+  // 从障碍物出发或者到达障碍物都算作无穷大的边权
+  std::vector<std::vector<std::pair<int, int>>> pred;
+  // 后继
+  std::vector<std::vector<int>> succ;
+
+  // 建图, 允许重复执行
+  void setupGraph(bool use_4directions);
+  // 节点 x 变成障碍物, 和它相连的边权全部设为无穷大
+  void blockEdges(int x);
+  // 节点 x 不再是障碍物, 恢复和它相连的边权 (另一端不是障碍物的)
+  void restoreEdges(int x);
 };
 
 #endif
@@ -0,0 +1,324 @@
+#include "cpd.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <thread>
+
+#include "impl_dijkstra.h"
+
+// 复用 dijkstra 的图和开放列表, 但是不在目标处停止, 而是遍历全部可达的方格,
+// 并沿着最短路树把出发点的第一步传递下去
+class FirstMoveDijkstra : public AlgorithmImplDijkstra {
+ public:
+  explicit FirstMoveDijkstra(bool use_4directions)
+      : use_4directions(use_4directions) {}
+  // moves[x] 是 source 到 x 的全部最短路的第一步的集合,
+  // 第 k 位表示 DIRECTIONS[k], 不可达时只有第 CPD_NO_MOVE 位
+  void Run(int source, std::vector<uint16_t> &moves);
+
+ private:
+  bool use_4directions;
+};
+
+// 从 x 走一步到邻居 y 的方向的位
+static uint16_t directionBit(int x, int y) {
+  int di = unpack_i(y) - unpack_i(x), dj = unpack_j(y) - unpack_j(x);
+  for (int k = 0; k < 8; k++)
+    if (DIRECTIONS[k].second == Point{di, dj}) return 1 << k;
+  return 0;
+}
+
+void FirstMoveDijkstra::Run(int source, std::vector<uint16_t> &moves) {
+  // 尺寸不变时都是 O(1) 的
+  setupEdges(use_4directions);
+  f.Resize(GRID_MAP.Size(), inf);
+  q.Reset(OpenList::Kind::Bucket);
+  moves.assign(GRID_MAP.Size(), 1 << CPD_NO_MOVE);
+  f[source] = 0;
+  q.push({0, source});
+  while (!q.empty()) {
+    auto [d, x] = q.top();
+    q.pop();
+    if (d > f[x]) continue;  // 过期的重复元素
+    for (const auto &[w, y] : neighbors(x)) {
+      // 出发点的邻居的第一步就是自己的方向, 其余的继承最短路上的父节点.
+      // 边权都是正数, x 出队时它的全部父节点都已经出队, 集合是完整的
+      uint16_t m = x == source ? directionBit(source, y) : moves[x];
+      if (f[y] > d + w) {
+        f[y] = d + w;
+        moves[y] = m;
+        q.push({f[y], y});
+      } else if (f[y] == d + w) {
+        moves[y] |= m;  // 另一条一样短的最短路
+      }
+    }
+  }
+}
+
+// 目标的排列: 从每个未访问的可通行方格开始做深度优先遍历 (4 方向),
+// 按先序编号. 编号相邻的目标在地图上也相邻, 第一步更容易相同,
+// 比按行扫描的游程少很多. 障碍物排在最后.
+static std::vector<uint32_t> dfsOrder() {
+  int n = GRID_MAP.Size();
+  std::vector<uint32_t> order;
+  order.reserve(n);
+  std::vector<bool> seen(n, false);
+  std::vector<int> stack;
+  for (int x0 = 0; x0 < n; x0++) {
+    if (seen[x0] || GRID_MAP.Get(unpack_i(x0), unpack_j(x0))) continue;
+    seen[x0] = true;
+    stack.push_back(x0);
+    while (!stack.empty()) {
+      int x = stack.back();
+      stack.pop_back();
+      order.push_back(x);
+      int i = unpack_i(x), j = unpack_j(x);
+      for (int k = 3; k >= 0; k--) {
+        const auto &[di, dj] = DIRECTIONS[k].second;
+        int i1 = i + di, j1 = j + dj, y = pack(i1, j1);
+        if (!ValidatePoint(i1, j1) || seen[y] || GRID_MAP.Get(i1, j1)) continue;
+        seen[y] = true;
+        stack.push_back(y);
+      }
+    }
+  }
+  for (int x = 0; x < n; x++)
+    if (!seen[x]) order.push_back(x);
+  return order;
+}
+
+// 把出发点 s 的一行第一步方向, 按目标的排列做游程编码.
+// 目标的第一步可以是集合中的任何一个, 所以贪心地延长当前的游程:
+// 只要游程内所有目标的集合还有交集, 就不需要开始新的游程
+static void encodeRow(int s, const std::vector<uint16_t> &moves,
+                      const std::vector<uint32_t> &order,
+                      std::vector<uint32_t> &row) {
+  row.clear();
+  // 当前游程的起始序号, 和游程内全部目标的第一步的交集
+  uint32_t start = 0;
+  uint16_t common = 0;
+  for (uint32_t r = 0; r < order.size(); r++) {
+    int x = order[r];
+    // 障碍物目标和出发点自身不会被查询, 并入当前的游程
+    if (x == s || GRID_MAP.Get(unpack_i(x), unpack_j(x))) continue;
+    if (common & moves[x]) {
+      common &= moves[x];
+      continue;
+    }
+    // 第一个游程总是从 0 开始, 查询时二分查找一定有结果
+    if (common) row.push_back(start << 4 | std::countr_zero(common));
+    start = row.empty() ? 0 : r;
+    common = moves[x];
+  }
+  if (common) row.push_back(start << 4 | std::countr_zero(common));
+}
+
+// 地图方格的哈希 (FNV-1a)
+static uint64_t hashMap() {
+  uint64_t h = 14695981039346656037ull;
+  auto mix = [&](uint64_t v) {
+    h ^= v;
+    h *= 1099511628211ull;
+  };
+  mix(GRID_MAP.Rows());
+  mix(GRID_MAP.Cols());
+  for (int i = 0; i < GRID_MAP.Rows(); i++)
+    for (int j = 0; j < GRID_MAP.Cols(); j++) mix(GRID_MAP.Get(i, j));
+  return h;
+}
+
+int CompressedPathDatabase::Build(bool use_4directions, int threads) {
+  if (GRID_MAP.Tiles() != nullptr) {
+    spdlog::error("CPD: 不支持分块存储的地图");
+    return -1;
+  }
+  // 游程中目标的序号只有 28 位
+  if (GRID_MAP.Size() >= (1 << 28)) {
+    spdlog::error("CPD: 地图太大 ({}x{})", GRID_MAP.Rows(), GRID_MAP.Cols());
+    return -1;
+  }
+  auto t0 = std::chrono::steady_clock::now();
+  M = GRID_MAP.Rows();
+  N = GRID_MAP.Cols();
+  this->use_4directions = use_4directions;
+  map_hash = hashMap();
+  // 邻居位掩码先算好, 之后各个线程对地图都是只读的
+  GRID_MAP.PrepareNeighborMasks();
+  auto order = dfsOrder();
+  ranks.assign(order.size(), 0);
+  for (uint32_t r = 0; r < order.size(); r++) ranks[order[r]] = r;
+
+  // 出发点按标号动态分给各个线程, 每个线程有自己的 dijkstra 状态,
+  // 每一行只被一个线程写入
+  int n = GRID_MAP.Size();
+  std::vector<std::vector<uint32_t>> rows(n);
+  std::atomic<int> next = 0;
+  auto work = [&]() {
+    FirstMoveDijkstra dijkstra(use_4directions);
+    std::vector<uint16_t> moves;
+    for (int s; (s = next++) < n;) {
+      // 障碍物出发点不会被查询, 是空行
+      if (GRID_MAP.Get(unpack_i(s), unpack_j(s))) continue;
+      dijkstra.Run(s, moves);
+      encodeRow(s, moves, order, rows[s]);
+    }
+  };
+  threads = std::max(1, threads);
+  std::vector<std::thread> workers;
+  for (int k = 1; k < threads; k++) workers.emplace_back(work);
+  work();
+  for (auto &worker : workers) worker.join();
+
+  // 拼接各行
+  offsets.assign(n + 1, 0);
+  for (int s = 0; s < n; s++) offsets[s + 1] = offsets[s] + rows[s].size();
+  runs.clear();
+  runs.reserve(offsets[n]);
+  for (auto &row : rows) {
+    runs.insert(runs.end(), row.begin(), row.end());
+    std::vector<uint32_t>().swap(row);
+  }
+  auto ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - t0)
+                .count();
+  spdlog::info("CPD 构建耗时 {:.1f}ms ({} 个线程), {} 个游程, 占用 {:.1f}MB",
+               ms, threads, runs.size(), Bytes() / 1048576.0);
+  return 0;
+}
+
+int CompressedPathDatabase::Save(const std::string &filepath) const {
+  CpdHeader header{};
+  memcpy(header.magic, CPD_MAGIC, sizeof header.magic);
+  header.version = CPD_VERSION;
+  header.rows = M;
+  header.cols = N;
+  header.directions = use_4directions ? 4 : 8;
+  header.map_hash = map_hash;
+
+  std::ofstream f(filepath, std::ios::binary | std::ios::trunc);
+  if (!f) {
+    spdlog::error("CPD: 无法写入文件 {}", filepath);
+    return -1;
+  }
+  f.write(reinterpret_cast<const char *>(&header), sizeof header);
+  f.write(reinterpret_cast<const char *>(ranks.data()),
+          ranks.size() * sizeof(uint32_t));
+  f.write(reinterpret_cast<const char *>(offsets.data()),
+          offsets.size() * sizeof(uint64_t));
+  f.write(reinterpret_cast<const char *>(runs.data()),
+          runs.size() * sizeof(uint32_t));
+  if (!f) {
+    spdlog::error("CPD: 写入文件失败 {}", filepath);
+    return -1;
+  }
+  return 0;
+}
+
+int CompressedPathDatabase::Load(const std::string &filepath) {
+  std::ifstream f(filepath, std::ios::binary);
+  if (!f) {
+    spdlog::error("CPD: 无法打开文件 {}", filepath);
+    return -1;
+  }
+  CpdHeader header;
+  if (!f.read(reinterpret_cast<char *>(&header), sizeof header) ||
+      memcmp(header.magic, CPD_MAGIC, sizeof header.magic) != 0 ||
+      header.version != CPD_VERSION) {
+    spdlog::error("CPD: 不支持的文件格式或版本 {}", filepath);
+    return -2;
+  }
+  // 先检查尺寸, 以免按损坏的头部分配过大的内存.
+  // 地图的哈希在 Matches 中检查, 这里只保证查表不会越界
+  if (header.rows != static_cast<uint32_t>(GRID_MAP.Rows()) ||
+      header.cols != static_cast<uint32_t>(GRID_MAP.Cols()) ||
+      (header.directions != 4 && header.directions != 8)) {
+    spdlog::error("CPD: 数据库 ({}x{}, {} 方向) 和当前的地图 ({}x{}) 不匹配 {}",
+                  header.rows, header.cols, header.directions, GRID_MAP.Rows(),
+                  GRID_MAP.Cols(), filepath);
+    return -2;
+  }
+  size_t n = static_cast<size_t>(header.rows) * header.cols;
+  // 游程中目标的序号只有 28 位
+  if (n >= (1 << 28)) {
+    spdlog::error("CPD: 方格数量 {} 超过了游程编码的上限", n);
+    return -2;
+  }
+  // 游程部分的大小 = 文件大小 - 头部 - 序号 - 行偏移
+  f.seekg(0, std::ios::end);
+  size_t file_size = f.tellg();
+  size_t fixed_size = sizeof header + n * sizeof(uint32_t) +
+                      (n + 1) * sizeof(uint64_t);
+  if (file_size < fixed_size || (file_size - fixed_size) % sizeof(uint32_t)) {
+    spdlog::error("CPD: 文件大小不正确 {}", filepath);
+    return -2;
+  }
+  size_t run_count = (file_size - fixed_size) / sizeof(uint32_t);
+  f.seekg(sizeof header);
+  std::vector<uint32_t> new_ranks(n);
+  std::vector<uint64_t> new_offsets(n + 1);
+  if (!f.read(reinterpret_cast<char *>(new_ranks.data()),
+              new_ranks.size() * sizeof(uint32_t)) ||
+      !f.read(reinterpret_cast<char *>(new_offsets.data()),
+              new_offsets.size() * sizeof(uint64_t))) {
+    spdlog::error("CPD: 文件不完整 {}", filepath);
+    return -2;
+  }
+  // 行偏移从 0 开始不减, 最后一个等于游程的总数
+  bool ok = new_offsets[0] == 0 && new_offsets[n] == run_count;
+  for (size_t x = 0; ok && x < n; x++)
+    ok = new_offsets[x] <= new_offsets[x + 1] && new_ranks[x] < n;
+  if (!ok) {
+    spdlog::error("CPD: 行偏移或者目标序号不合法 {}", filepath);
+    return -2;
+  }
+  std::vector<uint32_t> new_runs(run_count);
+  if (!f.read(reinterpret_cast<char *>(new_runs.data()),
+              new_runs.size() * sizeof(uint32_t))) {
+    spdlog::error("CPD: 文件不完整 {}", filepath);
+    return -2;
+  }
+  // 每行的游程按起始序号严格递增, 第一个从序号 0 开始 (FirstMove 的二分查找
+  // 依赖这一点), 方向不超过 CPD_NO_MOVE
+  for (size_t x = 0; ok && x < n; x++) {
+    for (auto k = new_offsets[x]; ok && k < new_offsets[x + 1]; k++) {
+      ok = (new_runs[k] & 0xf) <= CPD_NO_MOVE &&
+           (k == new_offsets[x] ? new_runs[k] >> 4 == 0
+                                : new_runs[k] >> 4 > new_runs[k - 1] >> 4);
+    }
+  }
+  if (!ok) {
+    spdlog::error("CPD: 游程不合法 {}", filepath);
+    return -2;
+  }
+  M = header.rows;
+  N = header.cols;
+  use_4directions = header.directions == 4;
+  map_hash = header.map_hash;
+  ranks = std::move(new_ranks);
+  offsets = std::move(new_offsets);
+  runs = std::move(new_runs);
+  spdlog::info("CPD 加载成功 ({}x{}, {} 方向), {} 个游程, 占用 {:.1f}MB", M,
+               N, header.directions, runs.size(), Bytes() / 1048576.0);
+  return 0;
+}
+
+bool CompressedPathDatabase::Matches(bool use_4directions) const {
+  return !offsets.empty() && M == GRID_MAP.Rows() && N == GRID_MAP.Cols() &&
+         this->use_4directions == use_4directions && map_hash == hashMap();
+}
+
+int CompressedPathDatabase::FirstMove(int s, int t) const {
+  const auto *begin = runs.data() + offsets[s];
+  const auto *end = runs.data() + offsets[s + 1];
+  if (begin == end) return -1;  // 障碍物出发点
+  // 最后一个起始序号不超过 t 的序号的游程
+  uint32_t key = ranks[t] << 4 | 0xf;
+  int v = *(std::upper_bound(begin, end, key) - 1) & 0xf;
+  return v == CPD_NO_MOVE ? -1 : v;
+}
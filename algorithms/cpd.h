@@ -0,0 +1,78 @@
+#ifndef PATH_FINDING_VISUALIZER_ALGORITHM_CPD_H
+#define PATH_FINDING_VISUALIZER_ALGORITHM_CPD_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../base.h"
+
+// 压缩路径数据库 (CPD, Compressed Path Database)
+// 对固定的地图离线预处理: 从每个出发点做一次 dijkstra,
+// 记录到每个目标的最短路的第一步方向. 寻路时从起点开始, 每一步查一次表,
+// 不需要任何搜索.
+//
+// 同一个出发点到地图上相邻的目标的第一步往往相同, 所以把目标按深度优先遍历
+// 的先序排列, 再按这个顺序做游程编码. 每一行 (一个出发点) 是若干个游程,
+// 每个游程是 (起始目标的序号 << 4 | 方向).
+// 障碍物目标和出发点自身不会被查询, 算作通配, 并入前一个游程.
+// 查询时在行内二分查找, 是 O(log 游程数) 的.
+//
+// 文件格式 (小端):
+//
+//   | 头部 CpdHeader (32 字节) | 目标的序号 (uint32, M*N 个) |
+//   | 行偏移 (uint64, M*N+1 个) | 游程 (uint32) |
+
+// 文件头的魔数
+const char CPD_MAGIC[4] = {'P', 'F', 'C', 'P'};
+// 当前的格式版本
+const uint32_t CPD_VERSION = 1;
+// 游程中表示 "不可达" 的方向
+const int CPD_NO_MOVE = 8;
+
+struct CpdHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t rows;        // 行数 M
+  uint32_t cols;        // 列数 N
+  uint32_t directions;  // 4 或者 8
+  uint32_t reserved;
+  uint64_t map_hash;  // 构建时的地图方格的哈希, 加载后用来检查地图是否匹配
+};
+
+static_assert(sizeof(CpdHeader) == 32);
+
+class CompressedPathDatabase {
+ public:
+  // 为当前的 GRID_MAP 构建, 出发点分给 threads 个线程并行, 成功返回 0
+  // 不支持分块存储的地图 (分块的缓存不是线程安全的)
+  int Build(bool use_4directions, int threads);
+  // 保存到文件, 成功返回 0
+  int Save(const std::string &filepath) const;
+  // 从文件加载, 成功返回 0. 数据库的尺寸必须和当前的 GRID_MAP 相同,
+  // 损坏的文件 (大小, 行偏移或者游程不合法) 会被拒绝
+  int Load(const std::string &filepath);
+  // 是否是为当前的 GRID_MAP 和方向数构建的
+  bool Matches(bool use_4directions) const;
+  // 从 s 到 t 的最短路的第一步, 是 DIRECTIONS 的下标, 不可达返回 -1
+  int FirstMove(int s, int t) const;
+  // 游程的总数
+  size_t Runs() const { return runs.size(); }
+  // 占用的内存 (字节)
+  size_t Bytes() const {
+    return ranks.size() * sizeof(uint32_t) +
+           offsets.size() * sizeof(uint64_t) + runs.size() * sizeof(uint32_t);
+  }
+
+ private:
+  int M = 0, N = 0;
+  bool use_4directions = false;
+  uint64_t map_hash = 0;
+  // ranks[x] 是目标 x 在游程编码中的序号
+  std::vector<uint32_t> ranks;
+  // 第 s 行的游程是 runs[offsets[s], offsets[s+1])
+  std::vector<uint64_t> offsets;
+  std::vector<uint32_t> runs;
+};
+
+#endif
@@ -0,0 +1,80 @@
+#include "flow_field_cache.h"
+
+FlowFieldCache FLOW_FIELD_CACHE;
+
+std::shared_ptr<const FlowField> FlowFieldCache::Get(const Key &key) {
+  std::lock_guard<std::mutex> lock(mu);
+  expire(key.version);
+  auto it = index.find(key);
+  if (it == index.end()) {
+    misses++;
+    return nullptr;
+  }
+  hits++;
+  // 移到最前面
+  lru.splice(lru.begin(), lru, it->second);
+  return it->second->second;
+}
+
+void FlowFieldCache::Put(const Key &key,
+                         std::shared_ptr<const FlowField> field) {
+  std::lock_guard<std::mutex> lock(mu);
+  expire(key.version);
+  if (auto it = index.find(key); it != index.end()) erase(it->second);
+  if (field == nullptr || field->Bytes() > budget) return;
+  bytes += field->Bytes();
+  lru.emplace_front(key, std::move(field));
+  index[key] = lru.begin();
+  shrink();
+}
+
+void FlowFieldCache::Expire(uint64_t version) {
+  std::lock_guard<std::mutex> lock(mu);
+  expire(version);
+}
+
+void FlowFieldCache::SetBudget(size_t bytes) {
+  std::lock_guard<std::mutex> lock(mu);
+  budget = bytes;
+  shrink();
+}
+
+void FlowFieldCache::Clear() {
+  std::lock_guard<std::mutex> lock(mu);
+  lru.clear();
+  index.clear();
+  bytes = 0;
+}
+
+long long FlowFieldCache::Hits() const {
+  std::lock_guard<std::mutex> lock(mu);
+  return hits;
+}
+
+long long FlowFieldCache::Misses() const {
+  std::lock_guard<std::mutex> lock(mu);
+  return misses;
+}
+
+size_t FlowFieldCache::Bytes() const {
+  std::lock_guard<std::mutex> lock(mu);
+  return bytes;
+}
+
+void FlowFieldCache::expire(uint64_t version) {
+  if (this->version == version) return;
+  this->version = version;
+  lru.clear();
+  index.clear();
+  bytes = 0;
+}
+
+void FlowFieldCache::shrink() {
+  while (bytes > budget) erase(std::prev(lru.end()));
+}
+
+void FlowFieldCache::erase(std::list<Entry>::iterator it) {
+  bytes -= it->second->Bytes();
+  index.erase(it->first);
+  lru.erase(it);
+}
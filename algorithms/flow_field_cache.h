@@ -0,0 +1,81 @@
+#ifndef PATH_FINDING_VISUALIZER_ALGORITHM_FLOW_FIELD_CACHE_H
+#define PATH_FINDING_VISUALIZER_ALGORITHM_FLOW_FIELD_CACHE_H
+
+#include <compare>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include "../base.h"
+
+// 一个目标的距离场和流场
+// 放入缓存之后是只读的, 可以在多个寻路实例之间共享
+struct FlowField {
+  // 到目标的距离, 按标号, 不可达是 inf
+  std::vector<int> dist;
+  // 流向, 是 DIRECTIONS 的下标, -1 表示没有流
+  Grid<signed char> flows;
+
+  // 占用的内存 (字节)
+  size_t Bytes() const {
+    return dist.size() * (sizeof(int) + sizeof(signed char));
+  }
+};
+
+// 进程内共享的流场缓存, 按 (目标, 地图版本, 方向数) 索引.
+// 前往同一个目标的寻路只需要沿着流向走, 是 O(路径长度) 的.
+// 总内存超过预算时, 淘汰最久没有使用的流场 (LRU).
+// 还被寻路实例持有的流场在淘汰后仍然有效, 只是不再被缓存.
+// 线程安全.
+class FlowFieldCache {
+ public:
+  struct Key {
+    int target;
+    uint64_t version;  // 地图版本 (GRID_MAP.Version())
+    bool use_4directions;
+    auto operator<=>(const Key &) const = default;
+  };
+
+  // 查找, 未命中返回 nullptr
+  std::shared_ptr<const FlowField> Get(const Key &key);
+  // 放入 (或者替换), 超过预算的流场不会被缓存
+  void Put(const Key &key, std::shared_ptr<const FlowField> field);
+  // 淘汰地图版本不是 version 的全部流场 (地图变化后它们不会再命中).
+  // Get 和 Put 遇到新的版本时也会自动淘汰
+  void Expire(uint64_t version);
+  // 设置内存预算 (字节), 0 表示不缓存
+  void SetBudget(size_t bytes);
+  // 清空
+  void Clear();
+
+  // 统计: 命中和未命中的次数, 和缓存的总内存
+  long long Hits() const;
+  long long Misses() const;
+  size_t Bytes() const;
+
+ private:
+  using Entry = std::pair<Key, std::shared_ptr<const FlowField>>;
+
+  mutable std::mutex mu;
+  size_t budget = 256ull << 20;
+  size_t bytes = 0;
+  // 当前缓存的流场的地图版本
+  uint64_t version = 0;
+  long long hits = 0, misses = 0;
+  // 按最近使用排列, 最前面的是最近使用的
+  std::list<Entry> lru;
+  std::map<Key, std::list<Entry>::iterator> index;
+
+  // 以下要求已经持有锁
+  void expire(uint64_t version);
+  // 淘汰到不超过预算
+  void shrink();
+  void erase(std::list<Entry>::iterator it);
+};
+
+// 全局的流场缓存
+extern FlowFieldCache FLOW_FIELD_CACHE;
+
+#endif
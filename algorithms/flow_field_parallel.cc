@@ -0,0 +1,153 @@
+#include "flow_field_parallel.h"
+
+#include <spdlog/spdlog.h>
+
+#include <bit>
+
+void ParallelDistanceField::Build(std::vector<int> &dist, int t,
+                                  bool use_4directions, ThreadPool &pool) {
+  int M = GRID_MAP.Rows(), N = GRID_MAP.Cols();
+  rows = (M + TILE - 1) / TILE;
+  cols = (N + TILE - 1) / TILE;
+  direction_mask = use_4directions ? 0x0f : 0xff;
+  for (int k = 0; k < 8; k++) {
+    const auto &[_, d] = DIRECTIONS[k];
+    offsets[k] = pack(d.first, d.second);
+  }
+  // 邻居位掩码先算好, 之后各个线程对地图都是只读的
+  GRID_MAP.PrepareNeighborMasks();
+  int tiles = rows * cols;
+  seeds.assign(tiles, {});
+  snapshot.assign(GRID_MAP.Size(), inf);
+  processed.assign(tiles, 0);
+  low.assign(tiles, inf);
+  queues.resize(pool.Threads());
+
+  int ti = unpack_i(t), tj = unpack_j(t);
+  seeds[tileOf(ti, tj)].push_back(t);
+  low[tileOf(ti, tj)] = 0;
+  // 有起点的分块, 和其中本轮要处理的分块
+  std::vector<int> active = {tileOf(ti, tj)}, ready, waiting, neighbors;
+  // 分块去重用的标记: 第 r 轮的邻居分块标记为 r, 仍在等待的分块标记为 -r
+  std::vector<int> mark(tiles, 0);
+  int round = 0;
+  long long relaxed_tiles = 0;
+  while (!active.empty()) {
+    round++;
+    // 只处理起点的距离不超过最小值 + DELTA 的分块 (类似 delta-stepping),
+    // 其余的分块留到之后, 等它们的起点更接近最终的距离时再处理,
+    // 以免同一个分块被波面从不同的方向反复修正
+    int lo = inf;
+    for (auto tile : active) lo = std::min(lo, low[tile]);
+    ready.clear();
+    waiting.clear();
+    for (auto tile : active)
+      (low[tile] <= lo + DELTA ? ready : waiting).push_back(tile);
+    relaxed_tiles += ready.size();
+    pool.ParallelFor(ready.size(), [&](int k, int thread) {
+      relaxTile(dist, ready[k], queues[thread]);
+    });
+    // 处理过的分块的全部邻居分块 (8 方向, 对角的边会跨越分块的角)
+    neighbors.clear();
+    for (auto tile : ready) {
+      processed[tile] = 1;
+      int r = tile / cols, c = tile % cols;
+      int r0 = std::max(0, r - 1), r1 = std::min(rows - 1, r + 1);
+      int c0 = std::max(0, c - 1), c1 = std::min(cols - 1, c + 1);
+      for (int r2 = r0; r2 <= r1; r2++) {
+        for (int c2 = c0; c2 <= c1; c2++) {
+          int u = r2 * cols + c2;
+          if (u == tile || mark[u] == round) continue;
+          mark[u] = round;
+          neighbors.push_back(u);
+        }
+      }
+    }
+    pool.ParallelFor(neighbors.size(),
+                     [&](int k, int) { pullTile(dist, neighbors[k]); });
+    for (auto tile : ready) processed[tile] = 0;
+    active = waiting;
+    for (auto u : waiting) mark[u] = -round;
+    for (auto u : neighbors)
+      if (!seeds[u].empty() && mark[u] != -round) active.push_back(u);
+  }
+  spdlog::info("并行距离场: {} 个分块, {} 轮, 共处理 {} 次分块", tiles, round,
+               relaxed_tiles);
+}
+
+void ParallelDistanceField::relaxTile(std::vector<int> &dist, int tile,
+                                      OpenList &q) {
+  int i0 = tile / cols * TILE, j0 = tile % cols * TILE;
+  int i1 = std::min(GRID_MAP.Rows(), i0 + TILE);
+  int j1 = std::min(GRID_MAP.Cols(), j0 + TILE);
+  // 起点的优先级没有规律, 用二叉堆
+  q.Reset(OpenList::Kind::Heap);
+  for (auto x : seeds[tile]) q.push({dist[x], x});
+  seeds[tile].clear();
+  low[tile] = inf;
+  while (!q.empty()) {
+    auto [d, x] = q.top();
+    q.pop();
+    if (d > dist[x]) continue;  // 过期的重复元素
+    int i = unpack_i(x), j = unpack_j(x);
+    for (unsigned mask = GRID_MAP.NeighborMask(x) & direction_mask; mask;
+         mask &= mask - 1) {
+      int k = std::countr_zero(mask);
+      const auto &[w, dk] = DIRECTIONS[k];
+      int i2 = i + dk.first, j2 = j + dk.second;
+      // 只松弛分块内部的边
+      if (i2 < i0 || i2 >= i1 || j2 < j0 || j2 >= j1) continue;
+      int y = x + offsets[k];
+      if (dist[y] > d + w) {
+        dist[y] = d + w;
+        q.push({dist[y], y});
+      }
+    }
+  }
+  // 边界方格的快照
+  for (int j = j0; j < j1; j++) {
+    snapshot[pack(i0, j)] = dist[pack(i0, j)];
+    snapshot[pack(i1 - 1, j)] = dist[pack(i1 - 1, j)];
+  }
+  for (int i = i0; i < i1; i++) {
+    snapshot[pack(i, j0)] = dist[pack(i, j0)];
+    snapshot[pack(i, j1 - 1)] = dist[pack(i, j1 - 1)];
+  }
+}
+
+void ParallelDistanceField::pullTile(std::vector<int> &dist, int tile) {
+  int i0 = tile / cols * TILE, j0 = tile % cols * TILE;
+  int i1 = std::min(GRID_MAP.Rows(), i0 + TILE);
+  int j1 = std::min(GRID_MAP.Cols(), j0 + TILE);
+  auto pull = [&](int i, int j) {
+    int x = pack(i, j);
+    bool improved = false;
+    for (unsigned mask = GRID_MAP.NeighborMask(x) & direction_mask; mask;
+         mask &= mask - 1) {
+      int k = std::countr_zero(mask);
+      const auto &[w, dk] = DIRECTIONS[k];
+      int i2 = i + dk.first, j2 = j + dk.second;
+      if (i2 >= i0 && i2 < i1 && j2 >= j0 && j2 < j1) continue;
+      // 只有本轮处理过的分块的边界才可能变小
+      if (!processed[tileOf(i2, j2)]) continue;
+      int y = x + offsets[k];
+      if (dist[x] > snapshot[y] + w) {
+        dist[x] = snapshot[y] + w;
+        improved = true;
+      }
+    }
+    if (improved) {
+      seeds[tile].push_back(x);
+      low[tile] = std::min(low[tile], dist[x]);
+    }
+  };
+  // 分块的边界方格, 每个只考察一次
+  for (int j = j0; j < j1; j++) {
+    pull(i0, j);
+    if (i1 - 1 != i0) pull(i1 - 1, j);
+  }
+  for (int i = i0 + 1; i < i1 - 1; i++) {
+    pull(i, j0);
+    if (j1 - 1 != j0) pull(i, j1 - 1);
+  }
+}
@@ -0,0 +1,54 @@
+#ifndef PATH_FINDING_VISUALIZER_ALGORITHM_FLOW_FIELD_PARALLEL_H
+#define PATH_FINDING_VISUALIZER_ALGORITHM_FLOW_FIELD_PARALLEL_H
+
+#include <vector>
+
+#include "../base.h"
+#include "open_list.h"
+#include "thread_pool.h"
+
+// 按分块并行计算到目标的距离场.
+// 把地图切分成 TILE x TILE 的分块, 按轮次迭代, 直到没有距离变小:
+//   1. 并行地在波面附近的分块内做 dijkstra, 起点是之前距离变小的方格,
+//      只松弛分块内部的边;
+//   2. 并行地让第 1 步处理过的分块的邻居分块, 沿跨越分块的边,
+//      从它们的边界方格拉取距离, 距离变小的边界方格成为下一轮的起点.
+// 每个分块只写自己的方格, 第 2 步读的是第 1 步结束时的边界快照,
+// 所以不需要加锁. 每个方格的距离总是某条路径的长度, 收敛时每条边都满足
+// dist[y] <= dist[x] + w, 所以和单线程的 dijkstra 的结果完全相同.
+// 每一轮只处理波面附近的分块 (见 DELTA), 通常每个分块只需要处理一两次.
+class ParallelDistanceField {
+ public:
+  // 为当前的 GRID_MAP 计算到目标 t 的距离场 dist (按标号, 不可达是 inf)
+  // 不支持分块存储的地图 (分块的缓存不是线程安全的)
+  void Build(std::vector<int> &dist, int t, bool use_4directions,
+             ThreadPool &pool);
+
+ private:
+  static constexpr int TILE = 64;
+  // 每一轮处理的起点距离的范围, 大约是波面走过一个分块的距离
+  static constexpr int DELTA = TILE * COST_UNIT;
+  // 分块的行数和列数
+  int rows = 0, cols = 0;
+  unsigned direction_mask = 0xff;
+  // offsets[k] 是沿 DIRECTIONS[k] 走一步时标号的增量
+  int offsets[8];
+  // 每个分块下一轮的起点
+  std::vector<std::vector<int>> seeds;
+  // 每个分块的起点的最小距离
+  std::vector<int> low;
+  // 边界方格的距离快照, 由所在的分块在第 1 步结束时写入
+  std::vector<int> snapshot;
+  // 本轮在第 1 步处理过的分块
+  std::vector<unsigned char> processed;
+  // 每个线程的开放列表
+  std::vector<OpenList> queues;
+
+  int tileOf(int i, int j) const { return i / TILE * cols + j / TILE; }
+  // 第 1 步: 分块内的 dijkstra
+  void relaxTile(std::vector<int> &dist, int tile, OpenList &q);
+  // 第 2 步: 沿跨越分块的边拉取距离
+  void pullTile(std::vector<int> &dist, int tile);
+};
+
+#endif
@@ -0,0 +1,155 @@
+#include "flow_kernel.h"
+
+#include <cstdint>
+#include <cstring>
+
+// 只在 x86 的 GCC/Clang 上编译 SIMD 实现: 用 target 属性单独为这几个函数
+// 启用指令集, 其余代码不需要特殊的编译选项, 运行时再检查 CPU 是否支持
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+#define FLOW_KERNEL_X86
+#include <immintrin.h>
+#endif
+
+// 沿 DIRECTIONS[k] 的邻居所在的填充行, 已经对齐到第 0 列
+static void neighborRows(const int *const rows[3], const int *src[8]) {
+  for (int k = 0; k < 8; k++) {
+    const auto &[di, dj] = DIRECTIONS[k].second;
+    src[k] = rows[di + 1] + 1 + dj;
+  }
+}
+
+// 计算 [begin, n) 列的流向
+static void calcScalar(const int *const rows[3], int begin, int n,
+                       int directions, signed char *out) {
+  const int *src[8];
+  neighborRows(rows, src);
+  const int *mid = rows[1] + 1;
+  for (int j = begin; j < n; j++) {
+    int best = inf;
+    signed char flow = -1;
+    if (mid[j] != FLOW_BLOCKED) {
+      for (int k = 0; k < directions; k++) {
+        if (src[k][j] < best) {
+          best = src[k][j];
+          flow = k;
+        }
+      }
+    }
+    out[j] = flow;
+  }
+}
+
+#ifdef FLOW_KERNEL_X86
+
+// 一次 4 个方格
+__attribute__((target("sse4.1"))) static void calcSSE41(
+    const int *const rows[3], int n, int directions, signed char *out) {
+  const int *src[8];
+  neighborRows(rows, src);
+  const int *mid = rows[1] + 1;
+  const __m128i blocked = _mm_set1_epi32(FLOW_BLOCKED);
+  int j = 0;
+  for (; j + 4 <= n; j += 4) {
+    __m128i best = _mm_set1_epi32(inf), flow = _mm_set1_epi32(-1);
+    for (int k = 0; k < directions; k++) {
+      __m128i v =
+          _mm_loadu_si128(reinterpret_cast<const __m128i *>(src[k] + j));
+      // 严格小于才替换, 相同时保留靠前的方向
+      __m128i less = _mm_cmpgt_epi32(best, v);
+      best = _mm_min_epi32(best, v);
+      flow = _mm_blendv_epi8(flow, _mm_set1_epi32(k), less);
+    }
+    // 障碍物方格的流向是 -1 (全 1)
+    __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mid + j));
+    flow = _mm_or_si128(flow, _mm_cmpeq_epi32(c, blocked));
+    // 4 个 int32 收窄成 4 个字节
+    __m128i packed = _mm_packs_epi16(_mm_packs_epi32(flow, flow),
+                                     _mm_setzero_si128());
+    uint32_t bytes = _mm_cvtsi128_si32(packed);
+    memcpy(out + j, &bytes, 4);
+  }
+  calcScalar(rows, j, n, directions, out);
+}
+
+// 一次 8 个方格
+__attribute__((target("avx2"))) static void calcAVX2(const int *const rows[3],
+                                                     int n, int directions,
+                                                     signed char *out) {
+  const int *src[8];
+  neighborRows(rows, src);
+  const int *mid = rows[1] + 1;
+  const __m256i blocked = _mm256_set1_epi32(FLOW_BLOCKED);
+  int j = 0;
+  for (; j + 8 <= n; j += 8) {
+    __m256i best = _mm256_set1_epi32(inf), flow = _mm256_set1_epi32(-1);
+    for (int k = 0; k < directions; k++) {
+      __m256i v =
+          _mm256_loadu_si256(reinterpret_cast<const __m256i *>(src[k] + j));
+      // 严格小于才替换, 相同时保留靠前的方向
+      __m256i less = _mm256_cmpgt_epi32(best, v);
+      best = _mm256_min_epi32(best, v);
+      flow = _mm256_blendv_epi8(flow, _mm256_set1_epi32(k), less);
+    }
+    // 障碍物方格的流向是 -1 (全 1)
+    __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(mid + j));
+    flow = _mm256_or_si256(flow, _mm256_cmpeq_epi32(c, blocked));
+    // 收窄成字节. pack 在两个 128 位的半边内分别进行,
+    // 所以前 4 个方格在低半边的最低 4 字节, 后 4 个在高半边的最低 4 字节
+    __m256i packed = _mm256_packs_epi16(_mm256_packs_epi32(flow, flow),
+                                        _mm256_setzero_si256());
+    uint32_t lo = _mm_cvtsi128_si32(_mm256_castsi256_si128(packed));
+    uint32_t hi = _mm_cvtsi128_si32(_mm256_extracti128_si256(packed, 1));
+    memcpy(out + j, &lo, 4);
+    memcpy(out + j + 4, &hi, 4);
+  }
+  calcScalar(rows, j, n, directions, out);
+}
+
+#endif
+
+FlowKernel BestFlowKernel() {
+#ifdef FLOW_KERNEL_X86
+  static const FlowKernel best = []() {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return FlowKernel::AVX2;
+    if (__builtin_cpu_supports("sse4.1")) return FlowKernel::SSE41;
+    return FlowKernel::Scalar;
+  }();
+  return best;
+#else
+  return FlowKernel::Scalar;
+#endif
+}
+
+const char *FlowKernelName(FlowKernel kernel) {
+  switch (kernel) {
+    case FlowKernel::AVX2:
+      return "avx2";
+    case FlowKernel::SSE41:
+      return "sse4.1";
+    default:
+      return "scalar";
+  }
+}
+
+void FillFlowRow(const std::vector<int> &dist, int i, int *row) {
+  int N = GRID_MAP.Cols();
+  row[0] = row[N + 1] = FLOW_BLOCKED;
+  if (i < 0 || i >= GRID_MAP.Rows()) {
+    std::fill(row + 1, row + N + 1, FLOW_BLOCKED);
+    return;
+  }
+  const int *d = dist.data() + static_cast<size_t>(i) * N;
+  for (int j = 0; j < N; j++)
+    row[j + 1] = GRID_MAP.Get(i, j) ? FLOW_BLOCKED : d[j];
+}
+
+void CalcFlowRow(FlowKernel kernel, const int *const rows[3], int n,
+                 bool use_4directions, signed char *out) {
+  int directions = use_4directions ? 4 : 8;
+#ifdef FLOW_KERNEL_X86
+  if (kernel == FlowKernel::AVX2) return calcAVX2(rows, n, directions, out);
+  if (kernel == FlowKernel::SSE41) return calcSSE41(rows, n, directions, out);
+#endif
+  calcScalar(rows, 0, n, directions, out);
+}
@@ -0,0 +1,35 @@
+#ifndef PATH_FINDING_VISUALIZER_ALGORITHM_FLOW_KERNEL_H
+#define PATH_FINDING_VISUALIZER_ALGORITHM_FLOW_KERNEL_H
+
+#include <vector>
+
+#include "../base.h"
+
+// 从距离场提取流向的核心循环, 按整行计算.
+// 流向是距离最小的邻居的方向 (相同时取 DIRECTIONS 中靠前的),
+// 没有距离有限的邻居时是 -1, 障碍物方格是 -1.
+//
+// 距离先填充成上中下三行, 每行两端各多一个方格, 障碍物和地图外的方格都填成
+// FLOW_BLOCKED. 这样 8 个方向都只是同一组三行的不同偏移, 不需要边界检查和
+// 邻居位掩码, 可以用 SIMD 一次比较一段连续的方格.
+// 各个实现的结果完全相同, 运行时按 CPU 选择最快的一个.
+
+// 障碍物和地图外的方格的填充值, 比 inf 大, 永远不会被选为流向
+const int FLOW_BLOCKED = inf + 1;
+
+enum class FlowKernel { Scalar, SSE41, AVX2 };
+
+// 当前 CPU 支持的最快的实现
+FlowKernel BestFlowKernel();
+// 实现的名字, 用于日志
+const char *FlowKernelName(FlowKernel kernel);
+
+// 把第 i 行的距离填充到 row (N+2 个), 第 i 行在地图外时全部是 FLOW_BLOCKED
+void FillFlowRow(const std::vector<int> &dist, int i, int *row);
+
+// 计算一行的 n 个方格的流向, 写到 out.
+// rows 是上中下三行填充过的距离 (见 FillFlowRow)
+void CalcFlowRow(FlowKernel kernel, const int *const rows[3], int n,
+                 bool use_4directions, signed char *out);
+
+#endif
@@ -7,6 +7,11 @@ void AlgorithmImplAStar::Setup(Blackboard &b, const Options &options) {
   if (options.astar_heuristic_method == "euclidean") {
     heuristic_method = 2;
     spdlog::info("astar 选用欧式距离");
+  } else if (options.astar_heuristic_method == "landmarks") {
+    heuristic_method = 3;
+    spdlog::info("astar 选用地标启发");
+    // 地图变化后 (版本号不同) 才会重算距离表
+    landmarks.Prepare(options.use_4directions, options.landmark_count);
   } else {
     heuristic_method = 1;
     spdlog::info("astar 选用曼哈顿距离");
@@ -15,7 +20,9 @@ void AlgorithmImplAStar::Setup(Blackboard &b, const Options &options) {
   AlgorithmImplDijkstra::Setup(b, options);
 }
 
-int AlgorithmImplAStar ::Update(Blackboard &b) {
+int AlgorithmImplAStar::Step(Blackboard &b, const StepBudget &budget,
+                             StepUsage &used) {
+  StepMeter meter(budget, used);
   while (!q.empty()) {
     auto [_, x] = q.top();
     q.pop();
@@ -23,25 +30,32 @@ int AlgorithmImplAStar ::Update(Blackboard &b) {
     int i = unpack_i(x), j = unpack_j(x);
     // x 已经不算待扩展了, 恢复到 -1
     b.exploring[i][j] = -1;
-    if (b.visited[i][j]) continue;
+    b.MarkDirty(x);
+    if (b.visited[i][j]) {
+      // 过期的重复元素 (lazy 删除)
+      b.stale_pops++;
+      continue;
+    }
     b.visited[i][j] = true;
+    b.expansions++;
     // 到达目标, 及时退出 (将 return 0)
     if (t == x) break;
     // 添加邻居节点进入待扩展
-    for (const auto &[w, y] : edges[x]) {
+    for (const auto &[w, y] : neighbors(x)) {
       auto g = f[x] + w;           // s 到 y 的实际代价
       auto h = future_cost(y, t);  // y 到目标的未来代价的估计
       auto cost = g + heuristic_weight * h;  // 总代价 = 实际 + 权重*未来
       if (f[y] > g) {  // 如果当前实际代价比之前计算的更优
         f[y] = g;      // 维护 y 的实际代价
         b.exploring[unpack_i(y)][unpack_j(y)] = f[y];
+        b.MarkDirty(y);
         q.push({cost, y});
         from[y] = x;  // 最短路来源
       }
     }
-    return -1;
+    // 考察完一个点, 预算用完时暂停
+    if (!meter.Spend()) return -1;
   }
-  // 每次 Update 只考察一个点, 不算结束
   if (from[t] == inf) return -2;  // 失败
   // 已经结束,需要计算最短路
   buildShortestPathResult(b);
@@ -55,6 +69,8 @@ int AlgorithmImplAStar::future_cost(int y, int t) {
   // 注意乘以 10
   // 对于 y 的未来代价预估, 曼哈顿距离
   if (heuristic_method == 1) return (abs(ti - yi) + abs(tj - yj)) * COST_UNIT;
+  // 地标的三角不等式下界
+  if (heuristic_method == 3) return landmarks.Estimate(y, t);
   // 欧式距离
   return std::floor(std::hypot(abs(ti - yi), abs(tj - yj))) * COST_UNIT;
 }
@@ -15,20 +15,27 @@ int AlgorithmImplBidirectionalAStar::future_cost(int y, int t) {
 }
 
 std::pair<int, int> AlgorithmImplBidirectionalAStar::extend(
-    decltype(q1) &q, int f[n], int from[n], bool vis[n], bool vis_other[n],
-    int t, Blackboard &b) {
+    decltype(q1) &q, StampedArray<int> &f, StampedArray<int> &from,
+    StampedArray<unsigned char> &vis,
+    const StampedArray<unsigned char> &vis_other, int t, Blackboard &b) {
   int k = q.size();
   while (k--) {
     auto [_, x] = q.top();
     q.pop();
     if (x == t) break;  // 到达目标
-    if (vis[x]) continue;
+    if (vis[x]) {
+      // 过期的重复元素 (lazy 删除)
+      b.stale_pops++;
+      continue;
+    }
     vis[x] = true;
     b.visited[unpack_i(x)][unpack_j(x)] = true;
+    b.expansions++;
+    b.MarkDirty(x);
     // 判断重合
-    if (vis_other[x]) return {0, x};
+    if (vis_other.Get(x)) return {0, x};
     // 对于 x 的每个邻居 y 和 边权
-    for (const auto &[w, y] : edges[x]) {
+    for (const auto &[w, y] : neighbors(x)) {
       auto g = f[x] + w;           // s 到 y 的实际代价
       auto h = future_cost(y, t);  // y 到目标的未来代价的估计
       auto cost = g + h;           // 总代价 = 实际 + 未来
@@ -37,6 +44,7 @@ std::pair<int, int> AlgorithmImplBidirectionalAStar::extend(
         q.push({cost, y});
         from[y] = x;  // 最短路来源
         b.exploring[unpack_i(y)][unpack_j(y)] = f[y];
+        b.MarkDirty(y);
       }
     }
     // 每一帧只扩展一个点
@@ -60,7 +68,10 @@ void AlgorithmImplBidirectionalAStar::Setup(Blackboard &b,
   AlgorithmImplBidirectionalDijkstra::Setup(b, options);
 }
 
-int AlgorithmImplBidirectionalAStar ::Update(Blackboard &b) {
+int AlgorithmImplBidirectionalAStar::Step(Blackboard &b,
+                                           const StepBudget &budget,
+                                           StepUsage &used) {
+  StepMeter meter(budget, used);
   while (!q1.empty() && !q2.empty()) {
     // 优先扩展更小的
     std::pair<int, int> p;
@@ -71,8 +82,12 @@ int AlgorithmImplBidirectionalAStar ::Update(Blackboard &b) {
       // 扩展 2, 走向模板 s
       p = extend(q2, f2, from2, vis2, vis1, s, b);
     }
-    if (p.first == -1) return -1;  // 仍未结束
-    int x = p.second;              // 否则, 已经结束, x 是相遇点
+    if (p.first == -1) {
+      // 仍未结束, 预算用完时暂停
+      if (!meter.Spend()) return -1;
+      continue;
+    }
+    int x = p.second;  // 否则, 已经结束, x 是相遇点
     if (x != inf) {
       // 寻路成功
       std::vector<int> path;
@@ -90,9 +105,11 @@ void AlgorithmImplBidirectionalAStar::HandleMapChanges(
     Blackboard &b, const Options &options,
     const std::vector<Point> &to_become_obstacles,
     const std::vector<Point> &to_remove_obstacles) {
+  if (to_become_obstacles.empty() && to_remove_obstacles.empty()) return;
   // 不支持增量计算, 只可以重新计算
+  // 启发函数的设置和邻居位掩码都不变, 只重置搜索状态
   spdlog::info("astar-bi 算法不支持增量计算, 将重新计算");
-  Setup(b, options);
+  restart(b, options);
 }
 
 void AlgorithmImplBidirectionalAStar::HandleStartPointChange(
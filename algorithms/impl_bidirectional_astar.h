@@ -7,7 +7,7 @@
 class AlgorithmImplBidirectionalAStar
     : public AlgorithmImplBidirectionalDijkstra {
   void Setup(Blackboard &b, const Options &options) override;
-  int Update(Blackboard &b) override;
+  int Step(Blackboard &b, const StepBudget &budget, StepUsage &used) override;
   void HandleMapChanges(Blackboard &b, const Options &options,
                         const std::vector<Point> &to_become_obstacles,
                         const std::vector<Point> &to_remove_obstacles) override;
@@ -22,9 +22,11 @@ class AlgorithmImplBidirectionalAStar
   // t 是本次搜索的模板
   // 如果出现重合, 代表可以搜索结束,返回 {0, 相遇点}, 如果没有相遇点, 返回 {0,
   // inf}; 如果仍未结束, 返回 {-1, anything}
-  std::pair<int, int> extend(decltype(q1) &q, int f[n], int from[n],
-                             bool vis[n], bool vis_other[n], int t,
-                             Blackboard &b);
+  std::pair<int, int> extend(decltype(q1) &q, StampedArray<int> &f,
+                             StampedArray<int> &from,
+                             StampedArray<unsigned char> &vis,
+                             const StampedArray<unsigned char> &vis_other,
+                             int t, Blackboard &b);
   // 代价估算的启发式函数
   // 反向和正向的时候传入的目标不一样
   int future_cost(int x, int t);
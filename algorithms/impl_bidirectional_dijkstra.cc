@@ -3,23 +3,31 @@
 #include <spdlog/spdlog.h>
 
 std::pair<int, int> AlgorithmImplBidirectionalDijkstra::extend(
-    decltype(q1) &q, int f[n], int from[n], bool vis[n], bool vis_other[n],
-    Blackboard &b) {
+    decltype(q1) &q, StampedArray<int> &f, StampedArray<int> &from,
+    StampedArray<unsigned char> &vis,
+    const StampedArray<unsigned char> &vis_other, Blackboard &b) {
   int k = q.size();
   while (k--) {
     auto [_, x] = q.top();
     q.pop();
-    if (vis[x]) continue;
+    if (vis[x]) {
+      // 过期的重复元素 (lazy 删除)
+      b.stale_pops++;
+      continue;
+    }
     vis[x] = true;
     b.visited[unpack_i(x)][unpack_j(x)] = true;
+    b.expansions++;
+    b.MarkDirty(x);
     // 判断重合
-    if (vis_other[x]) return {0, x};
-    for (const auto &[w, y] : edges[x]) {
+    if (vis_other.Get(x)) return {0, x};
+    for (const auto &[w, y] : neighbors(x)) {
       if (f[y] > f[x] + w) {
         f[y] = f[x] + w;
         q.push({f[y], y});
         from[y] = x;
         b.exploring[unpack_i(y)][unpack_j(y)] = f[y];
+        b.MarkDirty(y);
       }
     }
     // 每一帧只扩展一个点
@@ -31,20 +39,26 @@ std::pair<int, int> AlgorithmImplBidirectionalDijkstra::extend(
 
 void AlgorithmImplBidirectionalDijkstra::Setup(Blackboard &b,
                                                const Options &options) {
-  // 清理黑板
-  setupBlackboard(b);
   // 建图
   setupEdges(options.use_4directions);
+  restart(b, options);
+}
+
+void AlgorithmImplBidirectionalDijkstra::restart(Blackboard &b,
+                                                 const Options &options) {
+  // 清理黑板
+  setupBlackboard(b);
   // 清理 f, 到无穷大
-  memset(f1, 0x3f, sizeof(f1));
-  memset(f2, 0x3f, sizeof(f2));
-  memset(vis1, 0, sizeof vis1);
-  memset(vis2, 0, sizeof vis2);
-  memset(from1, 0x3f, sizeof from1);
-  memset(from2, 0x3f, sizeof from2);
-  // 清理 queue
-  while (q1.size()) q1.pop();
-  while (q2.size()) q2.pop();
+  // 尺寸不变时都是 O(1) 的
+  resizeState(f1, inf);
+  resizeState(f2, inf);
+  resizeState(vis1, false);
+  resizeState(vis2, false);
+  resizeState(from1, inf);
+  resizeState(from2, inf);
+  // 清理 queue, 并选用开放列表的实现
+  q1.Reset(OpenListKindOf(options.open_list));
+  q2.Reset(OpenListKindOf(options.open_list));
   // 设置初始坐标, 目标坐标
   s = pack(options.start);
   t = pack(options.target);
@@ -55,7 +69,10 @@ void AlgorithmImplBidirectionalDijkstra::Setup(Blackboard &b,
   q2.push({f2[t], t});
 }
 
-int AlgorithmImplBidirectionalDijkstra ::Update(Blackboard &b) {
+int AlgorithmImplBidirectionalDijkstra::Step(Blackboard &b,
+                                              const StepBudget &budget,
+                                              StepUsage &used) {
+  StepMeter meter(budget, used);
   // 优先扩展点更少的
   while (!q1.empty() && !q2.empty()) {
     // 优先扩展更小的
@@ -67,8 +84,12 @@ int AlgorithmImplBidirectionalDijkstra ::Update(Blackboard &b) {
       // 扩展 2
       p = extend(q2, f2, from2, vis2, vis1, b);
     }
-    if (p.first == -1) return -1;  // 仍未结束
-    int x = p.second;              // 否则, 已经结束, x 是相遇点
+    if (p.first == -1) {
+      // 仍未结束, 预算用完时暂停
+      if (!meter.Spend()) return -1;
+      continue;
+    }
+    int x = p.second;  // 否则, 已经结束, x 是相遇点
     if (x != inf) {
       // 寻路成功
       std::vector<int> path;
@@ -105,9 +126,11 @@ void AlgorithmImplBidirectionalDijkstra::HandleMapChanges(
     Blackboard &b, const Options &options,
     const std::vector<Point> &to_become_obstacles,
     const std::vector<Point> &to_remove_obstacles) {
+  if (to_become_obstacles.empty() && to_remove_obstacles.empty()) return;
   // dijkstra 不支持增量计算, 只可以重新计算
+  // 邻居位掩码已在 GridMap::Set 中修补, 不必再建图
   spdlog::info("dijkstra 算法不支持增量计算, 将重新计算");
-  Setup(b, options);
+  restart(b, options);
 }
 
 void AlgorithmImplBidirectionalDijkstra::HandleStartPointChange(
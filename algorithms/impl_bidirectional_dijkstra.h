@@ -1,38 +1,46 @@
 #ifndef PATH_FINDING_VISUALIZER_ALGORITHM_DIJKSTRA_BI_H
 #define PATH_FINDING_VISUALIZER_ALGORITHM_DIJKSTRA_BI_H
 
-#include <queue>
-
 #include "algorithm_base.h"
+#include "open_list.h"
 
 // -- 双向 Dijkstra 算法
 class AlgorithmImplBidirectionalDijkstra : public AlgorithmImplGraphBase {
  public:
   virtual void Setup(Blackboard &b, const Options &options) override;
-  virtual int Update(Blackboard &b) override;
+  virtual int Step(Blackboard &b, const StepBudget &budget,
+                   StepUsage &used) override;
   virtual void HandleMapChanges(
       Blackboard &b, const Options &options,
       const std::vector<Point> &to_become_obstacles,
       const std::vector<Point> &to_remove_obstacles) override;
   virtual void HandleStartPointChange(Blackboard &b,
                                       const Options &options) override;
+  bool SupportsTiledMap(const Options & /*options*/) const override {
+    return true;
+  }
 
  protected:
   // 1 是出发点正向, 2 是目标点反向
-  std::priority_queue<P, std::vector<P>, std::greater<P>> q1, q2;
+  OpenList q1, q2;
   // 最短路结果是相遇点 x 的 f1[x] + f2[x]
-  int f1[n], f2[n];
+  StampedArray<int> f1, f2;
   // from 保存最短路来源
-  int from1[n], from2[n];
+  StampedArray<int> from1, from2;
   // 访问数组
-  bool vis1[n], vis2[n];
+  StampedArray<unsigned char> vis1, vis2;
 
+  // 重置搜索状态和黑板, 不重新建图
+  void restart(Blackboard &b, const Options &options);
   // 扩展一次队列 q (是扩展一层)
   // vis 是自己的访问数组, vis_other 是对方的访问数组, 如果出现重合,
   // 代表可以搜索结束, 返回 {0, 相遇点}, 如果没有相遇点, 返回 {0, inf};
   // 如果仍未结束, 返回 {-1, anything}
-  std::pair<int, int> extend(decltype(q1) &q, int f[n], int from[n],
-                             bool vis[n], bool vis_other[n], Blackboard &b);
+  std::pair<int, int> extend(decltype(q1) &q, StampedArray<int> &f,
+                             StampedArray<int> &from,
+                             StampedArray<unsigned char> &vis,
+                             const StampedArray<unsigned char> &vis_other,
+                             Blackboard &b);
   // 收集路径到给的参数 path 中, 其中 x 是相遇点
   void collect(int x, std::vector<int> &path);
 };
@@ -0,0 +1,129 @@
+#include "impl_cpd.h"
+
+#include <spdlog/spdlog.h>
+
+#include <mutex>
+#include <thread>
+
+// 不超过这个方格数的地图, 没有指定数据库文件时可以当场构建
+// (构建是 O(方格数^2) 的, 64x64 的地图单线程约半秒, 更大的地图需要离线构建)
+static const int INLINE_BUILD_LIMIT = 1 << 12;
+
+// 进程内共享的只读数据库. 批量查询时每个线程有自己的寻路实例,
+// 数据库由第一个需要它的实例加载或者构建, 其他实例等待并复用.
+struct SharedDatabase {
+  std::mutex mu;
+  // 数据库对应的文件, 方向数和地图尺寸; 加载或者构建失败时 db 是 nullptr
+  std::string file;
+  bool use_4directions = false;
+  int rows = -1, cols = -1;
+  std::shared_ptr<const CompressedPathDatabase> db;
+  // 最后一次检查的地图版本, 以及数据库对这个版本是否有效
+  uint64_t version = 0;
+  bool valid = false;
+};
+
+static SharedDatabase SHARED_CPD;
+
+// 取得和当前地图匹配的数据库, 没有时返回 nullptr
+static std::shared_ptr<const CompressedPathDatabase> acquireDatabase(
+    const Options &options) {
+  auto &shared = SHARED_CPD;
+  std::lock_guard<std::mutex> lock(shared.mu);
+  if (shared.file == options.cpd_file &&
+      shared.use_4directions == options.use_4directions &&
+      shared.rows == GRID_MAP.Rows() && shared.cols == GRID_MAP.Cols()) {
+    if (shared.db == nullptr) return nullptr;
+    if (shared.version != GRID_MAP.Version()) {
+      // 地图被修改过, 重新计算一次哈希 (改回原样的地图仍然可以查表).
+      // 过期的数据库不当场重建, 以免每次修改都要 O(方格数^2) 的构建
+      shared.version = GRID_MAP.Version();
+      shared.valid = shared.db->Matches(options.use_4directions);
+      if (!shared.valid)
+        spdlog::warn("CPD: 地图已被修改, 数据库过期, 改用 A* 寻路");
+    }
+    return shared.valid ? shared.db : nullptr;
+  }
+
+  // 第一次使用, 或者换了数据库文件, 方向数, 地图尺寸: 加载或者构建
+  shared.file = options.cpd_file;
+  shared.use_4directions = options.use_4directions;
+  shared.rows = GRID_MAP.Rows();
+  shared.cols = GRID_MAP.Cols();
+  shared.version = GRID_MAP.Version();
+  shared.db = nullptr;
+  shared.valid = false;
+  auto db = std::make_shared<CompressedPathDatabase>();
+  if (!shared.file.empty()) {
+    if (db->Load(shared.file) != 0) return nullptr;
+    if (!db->Matches(shared.use_4directions)) {
+      spdlog::error("CPD: 数据库和当前的地图或者方向数不匹配, 需要重新构建");
+      return nullptr;
+    }
+  } else {
+    if (GRID_MAP.Size() > INLINE_BUILD_LIMIT) {
+      spdlog::error("CPD: 地图太大, 请用 cpd-builder 离线构建, 并通过 "
+                    "--cpd-file 指定");
+      return nullptr;
+    }
+    spdlog::info("CPD: 没有指定数据库文件, 当场构建");
+    int threads = std::thread::hardware_concurrency();
+    if (db->Build(shared.use_4directions, threads) != 0) return nullptr;
+  }
+  shared.db = std::move(db);
+  shared.valid = true;
+  return shared.db;
+}
+
+void AlgorithmImplCPD::Setup(Blackboard &b, const Options &options) {
+  // 清理黑板
+  setupBlackboard(b);
+  // 设置初始坐标和结束点
+  s = pack(options.start);
+  t = pack(options.target);
+  x = s;
+  db = acquireDatabase(options);
+  if (db == nullptr) {
+    spdlog::info("CPD: 没有可用的数据库, 改用 A* 寻路");
+    return fallback.Setup(b, options);
+  }
+  b.path.push_back(options.start);
+}
+
+int AlgorithmImplCPD::Step(Blackboard &b, const StepBudget &budget,
+                           StepUsage &used) {
+  if (db == nullptr) return fallback.Step(b, budget, used);
+  StepMeter meter(budget, used);
+  while (x != t) {
+    // 查表得到第一步, 走一步
+    int k = db->FirstMove(x, t);
+    if (k < 0) return -2;  // 不可达, 失败
+    const auto &[di, dj] = DIRECTIONS[k].second;
+    int i = unpack_i(x) + di, j = unpack_j(x) + dj;
+    x = pack(i, j);
+    b.visited[i][j] = true;
+    b.expansions++;
+    b.MarkDirty(x);
+    b.path.push_back({i, j});
+    if (!meter.Spend()) return -1;
+  }
+  b.isStopped = true;
+  return 0;
+}
+
+void AlgorithmImplCPD::HandleMapChanges(
+    Blackboard &b, const Options &options,
+    const std::vector<Point> &to_become_obstacles,
+    const std::vector<Point> &to_remove_obstacles) {
+  if (to_become_obstacles.empty() && to_remove_obstacles.empty()) return;
+  // 数据库只对构建时的地图有效, 过期后改用 A*, 不会当场重建
+  spdlog::info("CPD 是为固定地图预处理的, 地图变化后需要重新构建");
+  Setup(b, options);
+}
+
+void AlgorithmImplCPD::HandleStartPointChange(Blackboard &b,
+                                              const Options &options) {
+  // 查表不依赖之前的状态, 从新的起点重新出发即可
+  spdlog::info("CPD 从新的起点重新查表");
+  Setup(b, options);
+}
@@ -0,0 +1,34 @@
+#ifndef PATH_FINDING_VISUALIZER_ALGORITHM_CPD_ENGINE_H
+#define PATH_FINDING_VISUALIZER_ALGORITHM_CPD_ENGINE_H
+
+#include <memory>
+
+#include "algorithm_base.h"
+#include "cpd.h"
+#include "impl_astar.h"
+
+// 算法实现 - 压缩路径数据库查表 (见 cpd.h)
+// 数据库由 cpd-builder 离线构建, 通过 --cpd-file 指定;
+// 没有指定时, 很小的地图在第一次 Setup 时当场构建.
+// 每次 Update 查一次表, 沿最短路走一步, 不做任何搜索,
+// 黑板上的 path 是已经走过的前缀.
+// 数据库在全部寻路实例之间共享 (只读), 只对构建时的地图有效.
+// 地图修改后不会当场重建, 没有可用的数据库时改用 A* 寻路.
+class AlgorithmImplCPD : public AlgorithmImplBase {
+ public:
+  void Setup(Blackboard &b, const Options &options) override;
+  int Step(Blackboard &b, const StepBudget &budget, StepUsage &used) override;
+  void HandleMapChanges(Blackboard &b, const Options &options,
+                        const std::vector<Point> &to_become_obstacles,
+                        const std::vector<Point> &to_remove_obstacles) override;
+  void HandleStartPointChange(Blackboard &b, const Options &options) override;
+
+ private:
+  // 和当前地图匹配的数据库, 没有时是 nullptr, 由 fallback 寻路
+  std::shared_ptr<const CompressedPathDatabase> db;
+  AlgorithmImplAStar fallback;
+  // 当前走到的方格
+  int x = 0;
+};
+
+#endif
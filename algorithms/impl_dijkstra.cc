@@ -8,9 +8,9 @@ void AlgorithmImplDijkstra::Setup(Blackboard &b, const Options &options) {
   // 建图
   setupEdges(options.use_4directions);
   // 清理 f, 到无穷大
-  memset(f, 0x3f, sizeof(f));
-  // 清理 queue
-  while (q.size()) q.pop();
+  resizeState(f, inf);
+  // 清理 queue, 并选用开放列表的实现
+  q.Reset(OpenListKindOf(options.open_list));
   // 设置初始坐标 (or重设)
   s = pack(options.start);
   f[s] = 0;
@@ -20,7 +20,9 @@ void AlgorithmImplDijkstra::Setup(Blackboard &b, const Options &options) {
   t = pack(options.target);
 }
 
-int AlgorithmImplDijkstra ::Update(Blackboard &b) {
+int AlgorithmImplDijkstra::Step(Blackboard &b, const StepBudget &budget,
+                                StepUsage &used) {
+  StepMeter meter(budget, used);
   while (!q.empty()) {
     auto [_, x] = q.top();
     q.pop();
@@ -28,21 +30,28 @@ int AlgorithmImplDijkstra ::Update(Blackboard &b) {
     int i = unpack_i(x), j = unpack_j(x);
     // x 已经不算待扩展了, 恢复到 -1
     b.exploring[i][j] = -1;
-    if (b.visited[i][j]) continue;
+    b.MarkDirty(x);
+    if (b.visited[i][j]) {
+      // 过期的重复元素 (lazy 删除)
+      b.stale_pops++;
+      continue;
+    }
     b.visited[i][j] = true;
+    b.expansions++;
     // 到达目标, 及时退出 (将 return 0)
     if (t == x) break;
     // 添加邻居节点进入待扩展
-    for (const auto &[w, y] : edges[x]) {
+    for (const auto &[w, y] : neighbors(x)) {
       if (f[y] > f[x] + w) {
         f[y] = f[x] + w;
         from[y] = x;
         q.push({f[y], y});
         b.exploring[unpack_i(y)][unpack_j(y)] = f[y];
+        b.MarkDirty(y);
       }
     }
-    // 每次 Update 只考察一个点, 不算结束
-    return -1;
+    // 考察完一个点, 预算用完时暂停
+    if (!meter.Spend()) return -1;
   }
   // 已经结束,需要计算最短路
   if (from[t] == inf) return -2;  // 失败
@@ -0,0 +1,210 @@
+#include "impl_dstar_lite.h"
+
+#include <spdlog/spdlog.h>
+
+#include <vector>
+
+int AlgorithmImplDStarLite::h(int x, int y) {
+  // 方格内的坐标
+  auto xi = unpack_i(x), xj = unpack_j(x);
+  auto yi = unpack_i(y), yj = unpack_j(y);
+  // 曼哈顿
+  if (heuristic_method == 1) return (abs(xi - yi) + abs(xj - yj)) * COST_UNIT;
+  // 欧式距离
+  return std::floor(std::hypot(abs(xi - yi), abs(xj - yj))) * COST_UNIT;
+}
+
+AlgorithmImplDStarLite::K AlgorithmImplDStarLite::k(int x) {
+  // 启发是从起点到 x 的估计, 起点移动后用 km 修正
+  return {std::min(g[x], rhs[x]) + heuristic_weight * h(s, x) + km,
+          std::min(g[x], rhs[x]), x};
+}
+
+void AlgorithmImplDStarLite::update(int x) {
+  // 目标点不可更新, g[t] 和 rhs[t] 恒等于 0
+  if (x != t) {
+    // 根据 x 的后继节点的实际代价 g, 加上边权 w, 取最小.
+    // 边是双向的, 边权相同, 所以可以直接遍历 pred[x]
+    rhs[x] = inf;
+    for (auto [y, w] : pred[x]) rhs[x] = std::min(rhs[x], g[y] + w);
+  }
+  // 如果 x 的 g 和 rhs 没有对齐, 则加入队列 (或者修改 key) 等待更新
+  // 否则从队列中删除
+  if (g[x] != rhs[x])
+    q.Push(x, k(x));
+  else
+    q.Remove(x);
+}
+
+int AlgorithmImplDStarLite::collect(std::vector<int> &path) {
+  path.push_back(s);
+  // st 用来判环, 如果检测到, 则即时终止, 以防死循环
+  std::vector<bool> st(GRID_MAP.Size());
+  int x = s;
+  while (x != t) {
+    if (st[x]) {
+      spdlog::warn(
+          "得到的路径存在环, 可能启发函数设计不良存在高估, "
+          "将强制继续传播一轮以恢复");
+      force_stop_until_start = true;
+      return -1;
+    }
+    st[x] = 1;
+    // 找到 w + g 最小的后继邻居
+    int y1 = inf;
+    int g1 = inf;
+    for (const auto &[y, w] : pred[x]) {
+      if (g1 > g[y] + w) {
+        g1 = g[y] + w;
+        y1 = y;
+      }
+    }
+    if (y1 >= inf) break;
+    x = y1;
+    path.push_back(x);
+  }
+  return 0;
+}
+
+// 支持增量计算
+void AlgorithmImplDStarLite::HandleMapChanges(
+    Blackboard &b, const Options & /*options*/,
+    const std::vector<Point> &to_become_obstacles,
+    const std::vector<Point> &to_remove_obstacles) {
+  if (to_become_obstacles.empty() && to_remove_obstacles.empty()) return;
+  spdlog::info("DStarLite 支持增量计算, 将进行增量寻路修正");
+  // 清理一下黑板  (以完全重新渲染)
+  setupBlackboard(b);
+  // update 边权有变化的边的两端节点
+  for (const auto &[i, j] : to_become_obstacles) {
+    int x = pack(i, j);
+    blockEdges(x);
+    update(x);
+    for (auto y : succ[x]) update(y);
+  }
+  for (const auto &[i, j] : to_remove_obstacles) {
+    int x = pack(i, j);
+    restoreEdges(x);
+    update(x);
+    for (auto y : succ[x]) update(y);
+  }
+  spdlog::info("DStarLite 增量修改完毕");
+}
+
+void AlgorithmImplDStarLite::HandleStartPointChange(Blackboard &b,
+                                                    const Options &options) {
+  int s1 = pack(options.start);
+  spdlog::info("DStarLite 支持起始点变更, 将进行增量寻路修正");
+  // 清理一下黑板  (以完全重新渲染)
+  setupBlackboard(b);
+  // 队列中的键值都是按旧的起点计算的, 累加修正量后它们仍然是下界,
+  // 不需要重新计算整个队列
+  km += heuristic_weight * h(s, s1);
+  s = s1;
+  force_stop_until_start = false;
+}
+
+void AlgorithmImplDStarLite::Setup(Blackboard &b, const Options &options) {
+  heuristic_weight = options.astar_heuristic_weight;
+  if (heuristic_weight > 1) {
+    spdlog::warn(
+        "选用 DStarLite 时的启发权重设置为 > 1, 这可能会引起代价高估, "
+        "导致增量计算不充分");
+  }
+  if (options.astar_heuristic_method == "euclidean" ||
+      options.astar_heuristic_method == "landmarks") {
+    // 地标的距离表在地图变化后需要修正并重算队列的键值, 目前只有 astar 和
+    // lpastar 支持
+    if (options.astar_heuristic_method == "landmarks")
+      spdlog::warn("DStarLite 不支持地标启发, 改用欧式距离");
+    heuristic_method = 2;
+    spdlog::info("DStarLite 选用欧式距离");
+  } else {
+    heuristic_method = 1;
+    spdlog::info("DStarLite 选用曼哈顿距离");
+    if (!options.use_4directions)
+      spdlog::warn("DStarLite 在8方向上采用曼哈顿可能会引起代价高估");
+  }
+  // 清理黑板
+  setupBlackboard(b);
+  // 建图
+  setupGraph(options.use_4directions);
+
+  // 清理 q
+  q.Reset(GRID_MAP.Size());
+  // 设置初始坐标
+  s = pack(options.start);
+  // 设置结束点
+  t = pack(options.target);
+  // 初始化, 从目标开始反向搜索
+  km = 0;
+  force_stop_until_start = false;
+  g.assign(GRID_MAP.Size(), inf);
+  rhs.assign(GRID_MAP.Size(), inf);
+  rhs[t] = 0;
+  q.Push(t, k(t));
+}
+
+int AlgorithmImplDStarLite::Step(Blackboard &b, const StepBudget &budget,
+                                 StepUsage &used) {
+  StepMeter meter(budget, used);
+  std::vector<int> path;
+  while (true) {
+    while (!q.Empty()) {
+      if ((!force_stop_until_start) && q.TopKey() >= k(s) && rhs[s] == g[s])
+        break;
+
+      int x = q.Top();
+      // 起点移动过, 队头的键值已经过期, 按新的键值重新入队
+      if (auto k1 = k(x); q.TopKey() < k1) {
+        q.Push(x, k1);
+        b.stale_pops++;
+        continue;
+      }
+      // 弹出队头
+      q.Pop();
+
+      b.visited[unpack_i(x)][unpack_j(x)] = true;
+      b.expansions++;
+      b.MarkDirty(x);
+
+      if (g[x] > rhs[x]) {
+        // 局部过一致
+        g[x] = rhs[x];
+      } else {
+        // 局部欠一致, 通常说明新增了障碍物
+        g[x] = inf;
+        update(x);
+      }
+      // 向前继节点传播, 更新邻域 (边是双向的, 前继就是 succ[x])
+      for (auto y : succ[x]) {
+        update(y);
+        b.exploring[unpack_i(y)][unpack_j(y)] = g[y];
+        b.MarkDirty(y);
+      }
+
+      // 已经扩散到起点, 并且起点是局部一致的, 可以终止.
+      // 起点局部欠一致时, g[s] 先被重置为无穷大,
+      // 此时 g[s] == rhs[s] == inf 并不代表不可达, 需要继续传播
+      if (x == s && g[s] == rhs[s] && g[s] < inf) break;
+
+      // 考察完一个点, 预算用完时暂停
+      if (!meter.Spend()) return -1;
+    }
+
+    // 已经结束, 需要计算最短路
+    if (g[s] >= inf) return -2;  // 失败
+
+    path.clear();
+    if (collect(path) == 0) break;
+    // 收集失败, 继续传播
+    if (!meter.Spend()) return -1;
+  }
+  // 收集成功, 重置 force_stop_until_start
+  force_stop_until_start = false;
+  // 输出到 blackboard, 路径已经是从起点到目标的顺序
+  b.path.clear();
+  for (auto x : path) b.path.push_back({unpack_i(x), unpack_j(x)});
+  b.isStopped = true;
+  return 0;
+}
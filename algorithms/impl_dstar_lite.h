@@ -0,0 +1,50 @@
+#ifndef PATH_FINDING_VISUALIZER_ALGORITHM_DSTAR_LITE_H
+#define PATH_FINDING_VISUALIZER_ALGORITHM_DSTAR_LITE_H
+
+#include <tuple>
+
+#include "algorithm_base.h"
+#include "indexed_heap.h"
+
+// 算法实现 - D* Lite
+// 和 LPA* 相同的增量计算, 但是从目标反向搜索到起点.
+// 这样 g 值是到目标的代价, 起点移动时不需要重新计算,
+// 只需要累加键值修正量 km, 保证队列中旧的键值仍然是下界.
+class AlgorithmImplDStarLite : public AlgorithmImplIncrementalBase {
+ public:
+  void Setup(Blackboard &b, const Options &options) override;
+  int Step(Blackboard &b, const StepBudget &budget, StepUsage &used) override;
+  void HandleMapChanges(Blackboard &b, const Options &options,
+                        const std::vector<Point> &to_become_obstacles,
+                        const std::vector<Point> &to_remove_obstacles) override;
+  void HandleStartPointChange(Blackboard &b, const Options &options) override;
+
+ private:
+  int heuristic_weight = 1;
+  int heuristic_method = 1;  // 1 曼哈顿, 2 欧式
+  // 同 LPAStar: 启发函数高估时, 强制传播到起点才终止
+  bool force_stop_until_start = false;
+  // { 键值k1, 键值k2, 标号 }
+  using K = std::tuple<int, int, int>;
+
+  // g 值: 当前点到目标的实际代价 (旧值)
+  // rhs 值: 当前点到目标的实际代价的临时值, 由后继节点更新而来
+  // 按标号存储, 大小是地图的节点总数
+  std::vector<int> g, rhs;
+  // 键值修正量, 起点每次移动时累加移动前后的启发距离
+  int km = 0;
+  // 优先级队列, 要支持修改和删除任意节点, 所以用带索引的堆
+  IndexedHeap<K> q;
+
+  // 启发函数, x 到 y 的估计代价
+  int h(int x, int y);
+  // 计算 queue 的 key 的函数
+  K k(int x);
+  // 更新节点
+  void update(int x);
+  // 收集最短路, 结果存储在入参 path (必须是空的)
+  // 收集失败, 返回 -1, 否则返回 0
+  int collect(std::vector<int> &path);
+};
+
+#endif
@@ -2,104 +2,188 @@
 
 #include <spdlog/spdlog.h>
 
+#include <bit>
+#include <chrono>
+
+#include "flow_kernel.h"
+
 void AlgorithmImplFlowField::Setup(Blackboard &b, const Options &options) {
   // 清理黑板
   setupBlackboard(b);
   // 支持流场
-  memset(b.flows, -1, sizeof b.flows);
   b.isSupportedFlowField = true;
   // 建图
   // 注意!!! NOTE: 实际应该反向建图, 但是这里是方格图,
   // 正反向是对称的 (边总是双向的).
   setupEdges(options.use_4directions);
-  // 清理距离场, 到无穷大
-  memset(dist, 0x3f, sizeof(dist));
-  // 清理 queue
-  while (q.size()) q.pop();
+  // 清理 queue, 并选用开放列表的实现
+  q.Reset(OpenListKindOf(options.open_list));
   // 设置目标和起始点
   s = pack(options.start);
   t = pack(options.target);
+  use_4directions = options.use_4directions;
+  threads = options.flow_field_threads;
+  if (threads > 1 && (pool == nullptr || pool->Threads() != threads))
+    pool = std::make_unique<ThreadPool>(threads);
+  // 命中缓存时不需要任何计算, Update 直接沿着流向收集路径
+  FLOW_FIELD_CACHE.SetBudget(static_cast<size_t>(options.flow_cache_mb)
+                             << 20);
+  if (auto cached = FLOW_FIELD_CACHE.Get(cache_key())) {
+    field = std::move(cached);
+    b.flows = {field, &field->flows};
+    is_flow_calc_done = true;
+    return;
+  }
   // 重设 is_flow_calc_done 标记
   is_flow_calc_done = false;
-  use_4directions = options.use_4directions;
+  // 清理距离场, 到无穷大. 旧的流场还被共享时不复制, 直接新建一个
+  if (field.use_count() > 1) field = nullptr;
+  auto &f = own(b);
+  f.dist.assign(GRID_MAP.Size(), inf);
+  f.flows.Resize(GRID_MAP.Rows(), GRID_MAP.Cols(), -1);
   // 初始化目标的 dist
-  dist[t] = 0;
-  q.push({dist[t], t});
+  f.dist[t] = 0;
+  // 多线程时在 Update 中一次算完, 不需要逐个点扩展
+  if (threads <= 1) q.push({f.dist[t], t});
 }
 
-int AlgorithmImplFlowField::Update(Blackboard &b) {
+FlowField &AlgorithmImplFlowField::own(Blackboard &b) {
+  // 黑板也持有一份引用, 先放开
+  b.flows = nullptr;
+  if (field == nullptr)
+    field = std::make_shared<FlowField>();
+  else if (field.use_count() > 1)
+    field = std::make_shared<FlowField>(*field);
+  b.flows = {field, &field->flows};
+  // field 是按非 const 创建的, 而且只被当前实例持有, 可以修改
+  return const_cast<FlowField &>(*field);
+}
+
+FlowFieldCache::Key AlgorithmImplFlowField::cache_key() const {
+  return {t, GRID_MAP.Version(), use_4directions};
+}
+
+int AlgorithmImplFlowField::Step(Blackboard &b, const StepBudget &budget,
+                                 StepUsage &used) {
+  StepMeter meter(budget, used);
   // 计算距离场: dijkstra 算法
-  while (!q.empty()) {
-    // q 不空, 说明还没计算完毕距离场
-    auto [_, x] = q.top();
-    q.pop();
-    int i = unpack_i(x), j = unpack_j(x);
-    b.exploring[i][j] = -1;
-    if (b.visited[i][j]) continue;
-    b.visited[i][j] = true;
-    for (const auto &[w, y] : edges[x]) {
-      if (dist[y] > dist[x] + w) {
-        dist[y] = dist[x] + w;
-        q.push({dist[y], y});
-        b.exploring[unpack_i(y)][unpack_j(y)] = dist[y];
+  // q 不空, 说明还没计算完毕距离场. 写时复制只需要在循环外检查一次
+  if (!q.empty()) {
+    auto &dist = own(b).dist;
+    while (!q.empty()) {
+      auto [_, x] = q.top();
+      q.pop();
+      int i = unpack_i(x), j = unpack_j(x);
+      b.exploring[i][j] = -1;
+      b.MarkDirty(x);
+      if (b.visited[i][j]) {
+        // 过期的重复元素 (lazy 删除)
+        b.stale_pops++;
+        continue;
       }
+      b.visited[i][j] = true;
+      b.expansions++;
+      for (const auto &[w, y] : neighbors(x)) {
+        if (dist[y] > dist[x] + w) {
+          dist[y] = dist[x] + w;
+          q.push({dist[y], y});
+          b.exploring[unpack_i(y)][unpack_j(y)] = dist[y];
+          b.MarkDirty(y);
+        }
+      }
+      // 考察完一个点, 预算用完时暂停
+      if (!meter.Spend()) return -1;
     }
-    // 每次 Update 只考察一个点, 不算结束
-    return -1;
   }
 
   if (!is_flow_calc_done) {
-    calc_flow(b);
+    auto t0 = std::chrono::steady_clock::now();
+    auto &f = own(b);
+    if (threads > 1) parallel.Build(f.dist, t, use_4directions, *pool);
+    calc_flow(f);
+    auto ms = std::chrono::duration<double, std::milli>(
+                  std::chrono::steady_clock::now() - t0)
+                  .count();
+    if (threads > 1)
+      spdlog::info("flow-field 并行计算流场耗时 {:.1f}ms ({} 个线程)", ms,
+                   threads);
     is_flow_calc_done = true;
-    return -1;
+    // 所有方格的箭头一起出现 (并行计算时也没有逐个扩展), 全部重绘
+    b.dirty_all = true;
+    // 放入缓存, 之后是只读的
+    FLOW_FIELD_CACHE.Put(cache_key(), field);
+    // 计算流场算作一步, 不能再分
+    if (!meter.Spend()) return -1;
   }
 
   // 收集路径
-  if (b.path.empty() && find(unpack_i(s), unpack_j(s), b.path, b)) {
+  if (b.path.empty() && find(unpack_i(s), unpack_j(s), b.path)) {
     b.isStopped = true;
     return 0;  // 寻路成功
   }
   return -2;  // 失败
 }
 
-void AlgorithmImplFlowField::calc_flow(Blackboard &b) {
-  spdlog::info("计算流场中");
-  // 计算 flow 场
-  int max_directions = use_4directions ? 4 : 8;
-  for (int i = 0; i < M; i++) {
-    for (int j = 0; j < N; j++) {
-      // 记录最小的 dist 的邻居
-      int min_dist = inf;
-      // 默认情况下, 方向值是 -1
-      b.flows[i][j] = -1;
-      // 如果当前格子是障碍物, 则不考虑流向
-      if (GRID_MAP[i][j]) continue;
-      for (int k = 0; k < max_directions; k++) {
-        const auto &[_, d] = DIRECTIONS[k];
-        auto i1 = i + d.first, j1 = j + d.second;
-        if (ValidatePoint(i1, j1) and !GRID_MAP[i1][j1]) {
-          // 确保邻居方格是合法的, 且不是障碍物
-          int y = pack(i1, j1);
-          if (min_dist > dist[y]) {
-            min_dist = dist[y];
-            b.flows[i][j] = k;
-          }
-        }
-      }
+void AlgorithmImplFlowField::calc_flow(FlowField &f) {
+  auto kernel = BestFlowKernel();
+  spdlog::info("计算流场中 ({})", FlowKernelName(kernel));
+  // 计算 flow 场: 按整行计算 (见 flow_kernel.h), 结果和 calc_flow_at 相同
+  int M = GRID_MAP.Rows(), N = GRID_MAP.Cols();
+  auto band = [&](int i0, int i1) {
+    // 上中下三行填充过的距离, 轮流使用
+    std::vector<int> buffer(3 * (N + 2));
+    int *slots[3] = {buffer.data(), buffer.data() + N + 2,
+                     buffer.data() + 2 * (N + 2)};
+    FillFlowRow(f.dist, i0 - 1, slots[0]);
+    FillFlowRow(f.dist, i0, slots[1]);
+    for (int i = i0; i < i1; i++) {
+      FillFlowRow(f.dist, i + 1, slots[2]);
+      CalcFlowRow(kernel, slots, N, use_4directions, f.flows[i]);
+      std::rotate(slots, slots + 1, slots + 3);
     }
+  };
+  if (threads > 1) {
+    // 按行分段并行, 每个方格只写自己的流向.
+    // 分段比线程多一些, 以便动态分配时负载均衡
+    int bands = std::min(M, threads * 4);
+    pool->ParallelFor(bands, [&](int k, int) {
+      band(M * k / bands, M * (k + 1) / bands);
+    });
+  } else {
+    band(0, M);
   }
   spdlog::info("计算流场完毕!");
 }
 
-bool AlgorithmImplFlowField::find(int i, int j, std::vector<Point> &path,
-                                  const Blackboard &b) {
+void AlgorithmImplFlowField::calc_flow_at(FlowField &f, int i, int j) {
+  // 记录最小的 dist 的邻居
+  int min_dist = inf;
+  // 默认情况下, 方向值是 -1
+  f.flows[i][j] = -1;
+  // 按邻居位掩码, 只考察合法的且不是障碍物的邻居方格
+  // 如果当前格子是障碍物, 掩码是 0, 不考虑流向
+  unsigned direction_mask = use_4directions ? 0x0f : 0xff;
+  unsigned mask = GRID_MAP.NeighborMask(pack(i, j)) & direction_mask;
+  for (; mask; mask &= mask - 1) {
+    int k = std::countr_zero(mask);
+    const auto &[_, d] = DIRECTIONS[k];
+    int y = pack(i + d.first, j + d.second);
+    if (min_dist > f.dist[y]) {
+      min_dist = f.dist[y];
+      f.flows[i][j] = k;
+    }
+  }
+}
+
+bool AlgorithmImplFlowField::find(int i, int j, std::vector<Point> &path) {
+  const auto &flows = field->flows;
   P x = {i, j};
   path.push_back(x);
   // 目标
   int ti = unpack_i(t), tj = unpack_j(t);
   while (!(i == ti && j == tj)) {
-    if (b.flows[i][j] == -1) return false;
-    const auto &[_, d] = DIRECTIONS[b.flows[i][j]];
+    if (flows[i][j] == -1) return false;
+    const auto &[_, d] = DIRECTIONS[flows[i][j]];
     i += d.first;
     j += d.second;
     x = {i, j};
@@ -112,9 +196,139 @@ void AlgorithmImplFlowField::HandleMapChanges(
     Blackboard &b, const Options &options,
     const std::vector<Point> &to_become_obstacles,
     const std::vector<Point> &to_remove_obstacles) {
-  // 不支持增量计算, 只可以重新计算
-  spdlog::info("flow-field 算法不支持增量计算, 将重新计算");
-  Setup(b, options);
+  if (to_become_obstacles.empty() && to_remove_obstacles.empty()) return;
+  // 距离场还没有计算完毕, 或者目标, 方向数, 地图尺寸变化了,
+  // 只可以重新计算
+  bool need_setup =
+      !is_flow_calc_done || field == nullptr ||
+      field->dist.size() != static_cast<size_t>(GRID_MAP.Size()) ||
+      use_4directions != options.use_4directions || t != pack(options.target);
+  for (const auto &p : to_become_obstacles) need_setup |= pack(p) == t;
+  for (const auto &p : to_remove_obstacles) need_setup |= pack(p) == t;
+  if (need_setup) {
+    spdlog::info("flow-field 距离场尚未完成或者目标变化, 将重新计算");
+    Setup(b, options);
+    return;
+  }
+
+  // 旧的地图版本的流场不会再命中, 先从缓存中淘汰, 通常就不需要复制
+  FLOW_FIELD_CACHE.Expire(GRID_MAP.Version());
+  auto &f = own(b);
+  int n = repair(f, options, to_become_obstacles, to_remove_obstacles);
+  // 清理黑板, 只标记距离变化的方格 (以便观察修正的范围)
+  b.visited.Reset();
+  b.exploring.Reset();
+  b.path.clear();
+  b.isStopped = false;
+  for (auto x : touched) b.visited[unpack_i(x)][unpack_j(x)] = true;
+  b.dirty_all = true;
+  // 流向只取决于自身的邻居位掩码和邻居的距离,
+  // 所以只需要重新计算这些方格和它们的邻居的流向
+  for (int k = 0; k < n; k++) {
+    int i = unpack_i(touched[k]), j = unpack_j(touched[k]);
+    for (const auto &[_, d] : DIRECTIONS)
+      if (ValidatePoint(i + d.first, j + d.second))
+        touch(pack(i + d.first, j + d.second));
+  }
+  for (auto x : touched) calc_flow_at(f, unpack_i(x), unpack_j(x));
+  FLOW_FIELD_CACHE.Put(cache_key(), field);
+  spdlog::info("flow-field 增量修正完毕, 修正了 {} 个方格, 重算 {} 个流向", n,
+               touched.size());
+}
+
+void AlgorithmImplFlowField::touch(int x) {
+  if (is_touched[x]) return;
+  is_touched[x] = true;
+  touched.push_back(x);
+}
+
+int AlgorithmImplFlowField::repair(
+    FlowField &f, const Options &options,
+    const std::vector<Point> &to_become_obstacles,
+    const std::vector<Point> &to_remove_obstacles) {
+  auto &dist = f.dist;
+  int n = GRID_MAP.Size();
+  raise_state.Resize(n, 0);
+  is_touched.Resize(n, false);
+  touched.clear();
+  auto kind = OpenListKindOf(options.open_list);
+  int directions = use_4directions ? 4 : 8;
+
+  // 1. 上升 (raise)
+  // 新增的障碍物删除了和它相连的边. 按旧的距离从小到大考察受影响的方格 y:
+  // 当前图上满足 dist[z] + w == dist[y] 的邻居 z 是 y 的支撑,
+  // 全部支撑都失效时 y 也失效. 边权都是正数, 支撑的距离比 y 小,
+  // 考察 y 时它们的状态都已经确定.
+  std::vector<int> raised;
+  q.Reset(kind);
+  for (const auto &[i, j] : to_become_obstacles) {
+    int x = pack(i, j);
+    touch(x);  // 邻居位掩码变了
+    if (dist[x] >= inf || raise_state[x] == 1) continue;
+    raise_state[x] = 1;
+    raised.push_back(x);
+    // 障碍物的邻居位掩码已经是 0, 按方向直接找到原来的邻居
+    for (int k = 0; k < directions; k++) {
+      const auto &[_, d] = DIRECTIONS[k];
+      if (!ValidatePoint(i + d.first, j + d.second)) continue;
+      int y = pack(i + d.first, j + d.second);
+      if (dist[y] > dist[x] && dist[y] < inf) q.push({dist[y], y});
+    }
+  }
+  while (!q.empty()) {
+    auto [d, y] = q.top();
+    q.pop();
+    if (raise_state[y] != 0 || y == t) continue;  // 已经确定
+    bool supported = false;
+    for (const auto &[w, z] : neighbors(y)) {
+      if (raise_state[z] != 1 && dist[z] + w == d) {
+        supported = true;
+        break;
+      }
+    }
+    if (supported) {
+      raise_state[y] = 2;
+      continue;
+    }
+    raise_state[y] = 1;
+    raised.push_back(y);
+    // 只有距离更大的邻居可能以 y 为支撑
+    for (const auto &[w, z] : neighbors(y))
+      if (dist[z] > d && dist[z] < inf) q.push({dist[z], z});
+  }
+  for (auto x : raised) {
+    dist[x] = inf;
+    touch(x);
+  }
+
+  // 2. 下降 (lower)
+  // 失效的方格从仍然有效的邻居重新取得距离, 新的可通行方格也一样,
+  // 然后像 dijkstra 一样向外传播变小的距离.
+  q.Reset(kind);
+  auto seed = [&](int x) {
+    for (const auto &[w, y] : neighbors(x))
+      dist[x] = std::min(dist[x], dist[y] + w);
+    if (dist[x] < inf) q.push({dist[x], x});
+  };
+  for (auto x : raised) seed(x);
+  for (const auto &p : to_remove_obstacles) {
+    int x = pack(p);
+    touch(x);
+    seed(x);
+  }
+  while (!q.empty()) {
+    auto [d, x] = q.top();
+    q.pop();
+    if (d > dist[x]) continue;  // 过期的重复元素
+    touch(x);
+    for (const auto &[w, y] : neighbors(x)) {
+      if (dist[y] > d + w) {
+        dist[y] = d + w;
+        q.push({dist[y], y});
+      }
+    }
+  }
+  return touched.size();
 }
 
 void AlgorithmImplFlowField::HandleStartPointChange(Blackboard &b,
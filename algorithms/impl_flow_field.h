@@ -1,15 +1,24 @@
 #ifndef PATH_FINDING_VISUALIZER_ALGORITHM_FLOW_FIELD_H
 #define PATH_FINDING_VISUALIZER_ALGORITHM_FLOW_FIELD_H
 
-#include <queue>
-
 #include "algorithm_base.h"
+#include "flow_field_cache.h"
+#include "flow_field_parallel.h"
+#include "open_list.h"
+#include "thread_pool.h"
 
 // 算法实现 - FlowField
+// 地图变化时增量修正距离场: 先让失去支撑的方格的距离上升 (raise),
+// 再从边界向内传播变小的距离 (lower), 只有距离变化的方格和它们的邻居
+// 需要重新计算流向.
+// 计算完毕的流场放入全局的缓存 (见 flow_field_cache.h), 前往同一个目标的
+// 寻路直接复用, 不需要任何搜索.
+// 多线程时一次算完整个流场: 距离场按分块并行 (见 flow_field_parallel.h),
+// 流向按行分段并行.
 class AlgorithmImplFlowField : public AlgorithmImplGraphBase {
  public:
   void Setup(Blackboard &b, const Options &options) override;
-  int Update(Blackboard &b) override;
+  int Step(Blackboard &b, const StepBudget &budget, StepUsage &used) override;
   void HandleMapChanges(Blackboard &b, const Options &options,
                         const std::vector<Point> &to_become_obstacles,
                         const std::vector<Point> &to_remove_obstacles) override;
@@ -17,10 +26,10 @@ class AlgorithmImplFlowField : public AlgorithmImplGraphBase {
 
  protected:
   // dijkstra 的小根堆
-  std::priority_queue<P, std::vector<P>, std::greater<P>> q;
-  // 距离场, 按标号
-  int dist[n];
-  // 流场直接写到黑板
+  OpenList q;
+  // 距离场和流场, 黑板上的流场也指向它.
+  // 可能和缓存以及其他实例共享, 修改之前要先调用 own
+  std::shared_ptr<const FlowField> field;
 
   // 是否已经计算完毕流场
   bool is_flow_calc_done = false;
@@ -28,11 +37,35 @@ class AlgorithmImplFlowField : public AlgorithmImplGraphBase {
   // 是否支持四个方向
   bool use_4directions = false;
 
+  // 计算流场的线程数, 大于 1 时使用并行的构建
+  int threads = 1;
+  std::unique_ptr<ThreadPool> pool;
+  ParallelDistanceField parallel;
+
+  // 增量修正时方格的状态: 0 未考察, 1 距离上升 (失去支撑), 2 仍有支撑
+  StampedArray<unsigned char> raise_state;
+  // 增量修正时距离或者邻居位掩码可能变化的方格, 以及需要重新计算流向的方格
+  StampedArray<unsigned char> is_touched;
+  std::vector<int> touched;
+
+  // 取得可以修改的 field, 还被共享时先复制一份 (写时复制)
+  FlowField &own(Blackboard &b);
+  // 当前的流场在缓存中的键
+  FlowFieldCache::Key cache_key() const;
   // 寻找从点 (i,j) 出发的路径
   // 返回 false 表示失败
-  bool find(int i, int j, std::vector<Point> &path, const Blackboard &b);
+  bool find(int i, int j, std::vector<Point> &path);
   // 计算流程
-  void calc_flow(Blackboard &b);
+  void calc_flow(FlowField &f);
+  // 计算方格 (i,j) 的流向: 指向距离最小的邻居
+  void calc_flow_at(FlowField &f, int i, int j);
+  // 标记方格 x 需要重新计算流向
+  void touch(int x);
+  // 距离场的增量修正, 修正过的方格 (包括地图变化的方格) 记录在 touched,
+  // 返回它们的个数
+  int repair(FlowField &f, const Options &options,
+             const std::vector<Point> &to_become_obstacles,
+             const std::vector<Point> &to_remove_obstacles);
 };
 
 #endif
@@ -15,9 +15,9 @@ void AlgorithmImplGreedy::Setup(Blackboard &b, const Options &options) {
   // 建图
   setupEdges(options.use_4directions);
   // 清理 f, 到无穷大
-  memset(f, 0x3f, sizeof(f));
-  // 清理 queue
-  while (q.size()) q.pop();
+  resizeState(f, inf);
+  // 清理 queue, 并选用开放列表的实现
+  q.Reset(OpenListKindOf(options.open_list));
   // 设置初始坐标 (or重设)
   s = pack(options.start);
   f[s] = 0;
@@ -27,7 +27,9 @@ void AlgorithmImplGreedy::Setup(Blackboard &b, const Options &options) {
   t = pack(options.target);
 }
 
-int AlgorithmImplGreedy ::Update(Blackboard &b) {
+int AlgorithmImplGreedy::Step(Blackboard &b, const StepBudget &budget,
+                              StepUsage &used) {
+  StepMeter meter(budget, used);
   while (!q.empty()) {
     auto [_, x] = q.top();
     q.pop();
@@ -35,12 +37,18 @@ int AlgorithmImplGreedy ::Update(Blackboard &b) {
     int i = unpack_i(x), j = unpack_j(x);
     // x 已经不算待扩展了, 恢复到 -1
     b.exploring[i][j] = -1;
-    if (b.visited[i][j]) continue;
+    b.MarkDirty(x);
+    if (b.visited[i][j]) {
+      // 过期的重复元素 (lazy 删除)
+      b.stale_pops++;
+      continue;
+    }
     b.visited[i][j] = true;
+    b.expansions++;
     // 到达目标, 及时退出 (将 return 0)
     if (t == x) break;
     // 添加邻居节点进入待扩展
-    for (const auto &[w, y] : edges[x]) {
+    for (const auto &[w, y] : neighbors(x)) {
       auto g = f[x] + w;           // s 到 y 的实际代价
       auto h = future_cost(y, t);  // y 到目标的未来代价的估计
 
@@ -49,14 +57,15 @@ int AlgorithmImplGreedy ::Update(Blackboard &b) {
         // 维护 y 的实际代价
         f[y] = g;
         b.exploring[unpack_i(y)][unpack_j(y)] = f[y];
+        b.MarkDirty(y);
         // 贪心算法的时候, 未来估价直接作为优先级
         q.push({h, y});
         from[y] = x;  // 最短路来源
       }
     }
-    return -1;
+    // 考察完一个点, 预算用完时暂停
+    if (!meter.Spend()) return -1;
   }
-  // 每次 Update 只考察一个点, 不算结束
   if (from[t] == inf) return -2;  // 失败
   // 已经结束,需要计算最短路
   buildShortestPathResult(b);
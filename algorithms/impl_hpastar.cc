@@ -0,0 +1,416 @@
+#include "impl_hpastar.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <chrono>
+#include <set>
+
+// 入口的长度不小于这个值时, 在两端各放一对节点, 否则只在中间放一对
+static const int LONG_ENTRANCE = 6;
+
+void AlgorithmImplHPAStar::Setup(Blackboard &b, const Options &options) {
+  // 清理黑板
+  setupBlackboard(b);
+  // 建图 (簇内搜索用邻居位掩码)
+  setupEdges(options.use_4directions);
+  // 抽象图过期, 或者参数变化时, 重建抽象图
+  int cluster_size = std::max(2, options.hpa_cluster_size);
+  if (!graph_built || graph_version != GRID_MAP.Version() ||
+      C != cluster_size || use_4directions != options.use_4directions) {
+    C = cluster_size;
+    use_4directions = options.use_4directions;
+    buildGraph();
+  }
+  // 设置初始坐标和结束点
+  s = pack(options.start);
+  t = pack(options.target);
+  // 清理抽象图上的搜索状态
+  g.Resize(GRID_MAP.Size(), inf);
+  q.Reset(OpenListKindOf(options.open_list));
+  phase = 0;
+  abstract_path.clear();
+  refined = 0;
+  // 起点和终点接入抽象图
+  connectStartAndTarget();
+  g[s] = 0;
+  from[s] = s;
+  q.push({distance(s, t), s});
+}
+
+int AlgorithmImplHPAStar::Step(Blackboard &b, const StepBudget &budget,
+                               StepUsage &used) {
+  // 细化一段的开销比扩展一个节点大得多, 每一步都检查时间
+  StepMeter meter(budget, used, 1);
+  // 先在抽象图上搜索, 每一步扩展一个抽象节点
+  while (phase == 0 && !q.empty()) {
+    auto [_, x] = q.top();
+    q.pop();
+    int i = unpack_i(x), j = unpack_j(x);
+    // x 已经不算待扩展了, 恢复到 -1
+    b.exploring[i][j] = -1;
+    b.MarkDirty(x);
+    if (b.visited[i][j]) {
+      // 过期的重复元素 (lazy 删除)
+      b.stale_pops++;
+      continue;
+    }
+    b.visited[i][j] = true;
+    b.expansions++;
+    if (x == t) {
+      // 收集抽象路径, 开始细化
+      for (int y = t; y != s; y = from[y]) abstract_path.push_back(y);
+      abstract_path.push_back(s);
+      std::reverse(abstract_path.begin(), abstract_path.end());
+      b.path.push_back({unpack_i(s), unpack_j(s)});
+      phase = 1;
+      if (!meter.Spend()) return -1;
+      break;
+    }
+    successors(x);
+    for (const auto &[y, w] : succ) {
+      if (g[y] > g[x] + w) {
+        g[y] = g[x] + w;
+        from[y] = x;
+        q.push({g[y] + distance(y, t), y});
+        b.exploring[unpack_i(y)][unpack_j(y)] = g[y];
+        b.MarkDirty(y);
+      }
+    }
+    if (!meter.Spend()) return -1;
+  }
+  if (phase == 0) return -2;  // 抽象图上不可达, 失败
+
+  // 再逐段细化, 每一步细化一段
+  while (refined + 1 < abstract_path.size()) {
+    refineNextSegment(b);
+    if (refined + 1 < abstract_path.size() && !meter.Spend()) return -1;
+  }
+  b.isStopped = true;
+  return 0;
+}
+
+void AlgorithmImplHPAStar::HandleMapChanges(
+    Blackboard &b, const Options &options,
+    const std::vector<Point> &to_become_obstacles,
+    const std::vector<Point> &to_remove_obstacles) {
+  if (to_become_obstacles.empty() && to_remove_obstacles.empty()) return;
+  // 抽象图对应修改之前的地图版本时, 只修复受影响的簇.
+  // 每个方格的修改 (GridMap::Set) 让地图版本加一, 版本对不上时说明
+  // 还有没经过这里的修改 (比如修改时在用别的算法), 留给 Setup 重建
+  uint64_t edits = to_become_obstacles.size() + to_remove_obstacles.size();
+  bool is_fresh = graph_built && graph_version + edits == GRID_MAP.Version();
+  if (graph_built && !is_fresh) spdlog::info("HPA* 抽象图已经过期, 将重建");
+  if (is_fresh) {
+    auto changes = to_become_obstacles;
+    changes.insert(changes.end(), to_remove_obstacles.begin(),
+                   to_remove_obstacles.end());
+    repairGraph(changes);
+    graph_version = GRID_MAP.Version();
+  }
+  // 寻路本身重新开始
+  spdlog::info("HPA* 抽象图修复完毕, 将重新寻路");
+  Setup(b, options);
+}
+
+void AlgorithmImplHPAStar::HandleStartPointChange(Blackboard &b,
+                                                  const Options &options) {
+  // 抽象图不变, 只需要重新接入起点并搜索
+  spdlog::info("HPA* 复用抽象图, 将重新寻路");
+  Setup(b, options);
+}
+
+int AlgorithmImplHPAStar::distance(int x, int y) const {
+  int di = abs(unpack_i(x) - unpack_i(y));
+  int dj = abs(unpack_j(x) - unpack_j(y));
+  if (use_4directions) return (di + dj) * COST_UNIT;
+  // 先走斜线, 再走直线
+  return std::min(di, dj) * DIAGONAL_COST + abs(di - dj) * COST_UNIT;
+}
+
+void AlgorithmImplHPAStar::searchInCluster(int src, int k, int target) {
+  // 簇的范围 [i0, i1) x [j0, j1)
+  int i0 = k / CN * C, j0 = k % CN * C;
+  int i1 = std::min(GRID_MAP.Rows(), i0 + C);
+  int j1 = std::min(GRID_MAP.Cols(), j0 + C);
+  // 尺寸不变时都是 O(1) 的
+  cdist.Resize(GRID_MAP.Size(), inf);
+  cfrom.Resize(GRID_MAP.Size(), -1);
+  cq.Reset(OpenList::Kind::Bucket);
+  cdist[src] = 0;
+  cfrom[src] = src;
+  cq.push({0, src});
+  while (!cq.empty()) {
+    auto [d, x] = cq.top();
+    cq.pop();
+    if (d > cdist[x]) continue;  // 过期的重复元素
+    if (x == target) return;
+    for (const auto &[w, y] : neighbors(x)) {
+      int yi = unpack_i(y), yj = unpack_j(y);
+      if (yi < i0 || yi >= i1 || yj < j0 || yj >= j1) continue;  // 不出簇
+      if (cdist[y] > d + w) {
+        cdist[y] = d + w;
+        cfrom[y] = x;
+        cq.push({cdist[y], y});
+      }
+    }
+  }
+}
+
+/////////////////////////////////////
+/// 抽象图的构建和修复
+/////////////////////////////////////
+
+void AlgorithmImplHPAStar::buildGraph() {
+  auto t0 = std::chrono::steady_clock::now();
+  CM = (GRID_MAP.Rows() + C - 1) / C;
+  CN = (GRID_MAP.Cols() + C - 1) / C;
+  graph.clear();
+  node_refs.clear();
+  cluster_nodes.assign(CM * CN, {});
+  vborders.assign(CM * CN, {});
+  hborders.assign(CM * CN, {});
+  corners.assign(CM * CN, {});
+  // 先确定全部入口, 再计算簇内边
+  for (int k = 0; k < CM * CN; k++) {
+    if (k % CN + 1 < CN) buildBorder(k, true);
+    if (k / CN + 1 < CM) buildBorder(k, false);
+    if (k % CN + 1 < CN && k / CN + 1 < CM) buildCorner(k);
+  }
+  for (int k = 0; k < CM * CN; k++) buildClusterEdges(k);
+  graph_version = GRID_MAP.Version();
+  graph_built = true;
+  size_t edges = 0;
+  for (const auto &[_, es] : graph) edges += es.size();
+  auto ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - t0)
+                .count();
+  spdlog::info("HPA* 预处理耗时 {:.1f}ms, {} 个簇, {} 个抽象节点, {} 条边",
+               ms, CM * CN, graph.size(), edges / 2);
+}
+
+void AlgorithmImplHPAStar::buildBorder(int k, bool vertical) {
+  auto &entrances = vertical ? vborders[k] : hborders[k];
+  for (const auto &[u, v] : entrances) {
+    removeEdge(u, v);
+    removeNode(u);
+    removeNode(v);
+  }
+  entrances.clear();
+  int ci = k / CN, cj = k % CN;
+  // 边界的长度, 第 p 个位置在簇 k 一侧 (d=0) 和另一侧 (d=1) 的方格
+  int len = vertical ? std::min(C, GRID_MAP.Rows() - ci * C)
+                     : std::min(C, GRID_MAP.Cols() - cj * C);
+  auto side = [&](int p, int d) {
+    if (vertical) return pack(ci * C + p, cj * C + C - 1 + d);
+    return pack(ci * C + C - 1 + d, cj * C + p);
+  };
+  auto passable = [&](int p) {
+    int u = side(p, 0), v = side(p, 1);
+    return !GRID_MAP.Get(unpack_i(u), unpack_j(u)) &&
+           !GRID_MAP.Get(unpack_i(v), unpack_j(v));
+  };
+  // 在簇 k 一侧的第 p 个位置和另一侧的第 p1 个位置之间放一对节点
+  auto add = [&](int p, int p1) {
+    int u = side(p, 0), v = side(p1, 1);
+    addNode(u);
+    addNode(v);
+    addEdge(u, v, p == p1 ? COST_UNIT : DIAGONAL_COST);
+    entrances.push_back({u, v});
+  };
+  // 两侧都可以通行的每个连续段是一个入口
+  for (int p = 0; p < len; p++) {
+    if (!passable(p)) continue;
+    int e = p;
+    while (e + 1 < len && passable(e + 1)) e++;
+    if (e - p + 1 < LONG_ENTRANCE) {
+      add((p + e) / 2, (p + e) / 2);
+    } else {
+      add(p, p);
+      add(e, e);
+    }
+    p = e;
+  }
+  // 8 方向时, 还可以斜着跨过边界.
+  // 相邻的位置 p 或者 p+1 可以通行时, 斜穿和那个入口在两侧的簇内都是连通的,
+  // 只有两个位置都不可以通行时才需要单独的入口
+  if (use_4directions) return;
+  auto walkable = [&](int x) {
+    return !GRID_MAP.Get(unpack_i(x), unpack_j(x));
+  };
+  for (int p = 0; p + 1 < len; p++) {
+    if (passable(p) || passable(p + 1)) continue;
+    if (walkable(side(p, 0)) && walkable(side(p + 1, 1))) add(p, p + 1);
+    if (walkable(side(p + 1, 0)) && walkable(side(p, 1))) add(p + 1, p);
+  }
+}
+
+void AlgorithmImplHPAStar::buildCorner(int k) {
+  auto &entrances = corners[k];
+  for (const auto &[u, v] : entrances) {
+    removeEdge(u, v);
+    removeNode(u);
+    removeNode(v);
+  }
+  entrances.clear();
+  if (use_4directions) return;
+  // 簇 k 右下角的四个方格, 只有两条对角线可以跨过这个角.
+  // 对角线的另外两个方格都是障碍物时, 不能经由相邻的边界绕过去, 才需要入口
+  int i = k / CN * C + C - 1, j = k % CN * C + C - 1;
+  bool a = !GRID_MAP.Get(i, j), b = !GRID_MAP.Get(i, j + 1);
+  bool c = !GRID_MAP.Get(i + 1, j), d = !GRID_MAP.Get(i + 1, j + 1);
+  auto add = [&](int u, int v) {
+    addNode(u);
+    addNode(v);
+    addEdge(u, v, DIAGONAL_COST);
+    entrances.push_back({u, v});
+  };
+  if (a && d && !b && !c) add(pack(i, j), pack(i + 1, j + 1));
+  if (b && c && !a && !d) add(pack(i, j + 1), pack(i + 1, j));
+}
+
+void AlgorithmImplHPAStar::buildClusterEdges(int k) {
+  const auto &nodes = cluster_nodes[k];
+  // 删除旧的簇内边, 簇间边的另一端在别的簇, 保留
+  for (auto u : nodes) {
+    auto &es = graph[u];
+    es.erase(std::remove_if(
+                 es.begin(), es.end(),
+                 [&](const Edge &e) { return clusterOf(e.first) == k; }),
+             es.end());
+  }
+  // 从每个节点出发在簇内搜索一次, 得到到其他节点的距离
+  for (std::size_t a = 0; a < nodes.size(); a++) {
+    searchInCluster(nodes[a], k);
+    for (std::size_t c = a + 1; c < nodes.size(); c++)
+      if (auto d = cdist.Get(nodes[c]); d < inf) addEdge(nodes[a], nodes[c], d);
+  }
+}
+
+void AlgorithmImplHPAStar::addNode(int x) {
+  if (node_refs[x]++ > 0) return;
+  graph[x];
+  cluster_nodes[clusterOf(x)].push_back(x);
+}
+
+void AlgorithmImplHPAStar::removeNode(int x) {
+  if (--node_refs[x] > 0) return;
+  node_refs.erase(x);
+  // 删除和 x 相连的全部边
+  for (const auto &[y, _] : graph[x]) {
+    auto &es = graph[y];
+    es.erase(std::remove_if(es.begin(), es.end(),
+                            [&](const Edge &e) { return e.first == x; }),
+             es.end());
+  }
+  graph.erase(x);
+  auto &nodes = cluster_nodes[clusterOf(x)];
+  nodes.erase(std::find(nodes.begin(), nodes.end(), x));
+}
+
+void AlgorithmImplHPAStar::addEdge(int u, int v, int w) {
+  graph[u].push_back({v, w});
+  graph[v].push_back({u, w});
+}
+
+void AlgorithmImplHPAStar::removeEdge(int u, int v) {
+  for (auto [a, c] : {std::pair{u, v}, std::pair{v, u}}) {
+    auto &es = graph[a];
+    auto it = std::find_if(es.begin(), es.end(),
+                           [&](const Edge &e) { return e.first == c; });
+    if (it != es.end()) es.erase(it);
+  }
+}
+
+void AlgorithmImplHPAStar::repairGraph(const std::vector<Point> &changes) {
+  auto t0 = std::chrono::steady_clock::now();
+  // 受影响的边界: 变化的方格在边界上; 受影响的簇: 所在的簇, 和边界另一侧的簇
+  std::set<std::pair<int, bool>> borders;
+  std::set<int> clusters, corner_set;
+  for (const auto &[i, j] : changes) {
+    int ci = i / C, cj = j / C, k = ci * CN + cj;
+    clusters.insert(k);
+    if (j % C == C - 1 && cj + 1 < CN) {
+      borders.insert({k, true});
+      clusters.insert(k + 1);
+    }
+    if (j % C == 0 && cj > 0) {
+      borders.insert({k - 1, true});
+      clusters.insert(k - 1);
+    }
+    if (i % C == C - 1 && ci + 1 < CM) {
+      borders.insert({k, false});
+      clusters.insert(k + CN);
+    }
+    if (i % C == 0 && ci > 0) {
+      borders.insert({k - CN, false});
+      clusters.insert(k - CN);
+    }
+    // 变化的方格是某个角的四个方格之一, 这个角周围的四个簇都受影响
+    for (int ki = ci - (i % C == 0); ki <= ci; ki++)
+      for (int kj = cj - (j % C == 0); kj <= cj; kj++) {
+        if (ki < 0 || kj < 0 || ki + 1 >= CM || kj + 1 >= CN) continue;
+        bool on_row = i == ki * C + C - 1 || i == ki * C + C;
+        bool on_col = j == kj * C + C - 1 || j == kj * C + C;
+        if (!on_row || !on_col) continue;
+        int kc = ki * CN + kj;
+        corner_set.insert(kc);
+        for (int kk : {kc, kc + 1, kc + CN, kc + CN + 1}) clusters.insert(kk);
+      }
+  }
+  for (const auto &[k, vertical] : borders) buildBorder(k, vertical);
+  for (auto k : corner_set) buildCorner(k);
+  for (auto k : clusters) buildClusterEdges(k);
+  auto us = std::chrono::duration<double, std::micro>(
+                std::chrono::steady_clock::now() - t0)
+                .count();
+  spdlog::info("HPA* 增量修复了 {} 条边界, {} 个角, {} 个簇, 耗时 {:.1f}us",
+               borders.size(), corner_set.size(), clusters.size(), us);
+}
+
+/////////////////////////////////////
+/// 寻路
+/////////////////////////////////////
+
+void AlgorithmImplHPAStar::connectStartAndTarget() {
+  s_edges.clear();
+  t_edges.clear();
+  int ks = clusterOf(s), kt = clusterOf(t);
+  // 起点到所在簇内的各个节点
+  searchInCluster(s, ks);
+  for (auto v : cluster_nodes[ks])
+    if (auto d = cdist.Get(v); d < inf && v != s) s_edges.push_back({v, d});
+  // 同一个簇内, 也可以直接走到终点
+  if (ks == kt && cdist.Get(t) < inf) s_edges.push_back({t, cdist.Get(t)});
+  // 终点所在簇内的各个节点到终点 (边是双向的)
+  searchInCluster(t, kt);
+  for (auto v : cluster_nodes[kt])
+    if (auto d = cdist.Get(v); d < inf && v != t) t_edges[v] = d;
+}
+
+void AlgorithmImplHPAStar::successors(int x) {
+  succ.clear();
+  if (x == s) succ.insert(succ.end(), s_edges.begin(), s_edges.end());
+  if (auto it = graph.find(x); it != graph.end())
+    succ.insert(succ.end(), it->second.begin(), it->second.end());
+  if (auto it = t_edges.find(x); it != t_edges.end())
+    succ.push_back({t, it->second});
+}
+
+void AlgorithmImplHPAStar::refineNextSegment(Blackboard &b) {
+  int u = abstract_path[refined], v = abstract_path[refined + 1];
+  refined++;
+  // 簇间边, 或者相邻的两个节点, 直接走一步
+  for (const auto &[_, y] : neighbors(u)) {
+    if (y == v) {
+      b.path.push_back({unpack_i(v), unpack_j(v)});
+      return;
+    }
+  }
+  // 否则两个节点在同一个簇内, 在簇内搜索
+  searchInCluster(u, clusterOf(u), v);
+  std::vector<int> segment;
+  for (int x = v; x != u; x = cfrom[x]) segment.push_back(x);
+  for (int k = segment.size() - 1; k >= 0; k--)
+    b.path.push_back({unpack_i(segment[k]), unpack_j(segment[k])});
+}
@@ -0,0 +1,111 @@
+#ifndef PATH_FINDING_VISUALIZER_ALGORITHM_HPASTAR_H
+#define PATH_FINDING_VISUALIZER_ALGORITHM_HPASTAR_H
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "algorithm_base.h"
+#include "open_list.h"
+
+// 算法实现 - HPA* (Hierarchical Path-Finding A*)
+// 把地图切分成 C*C 的簇, 相邻簇的边界上可以通行的连续段是入口,
+// 入口两侧的方格是抽象节点. 抽象图的边有两种:
+//   簇间边: 入口两侧的一对节点, 代价是 COST_UNIT (8 方向时斜着跨过边界或者
+//           簇的角的入口, 代价是 DIAGONAL_COST)
+//   簇内边: 同一个簇内的两个节点, 代价是只在簇内行走的最短距离
+// 寻路时先把起点和终点接入抽象图, 在抽象图上做 A*, 再逐段细化成方格路径.
+// 细化是逐段进行的, 每次 Update 细化一段, 黑板上的 path 是已经细化好的前缀,
+// 所以不必等全部细化完成就可以沿着路径出发.
+// 地图变化时只重建受影响的边界入口和簇内边.
+// 结果不保证是最短路 (簇内边只在簇内行走), 但是通常很接近.
+class AlgorithmImplHPAStar : public AlgorithmImplGraphBase {
+ public:
+  void Setup(Blackboard &b, const Options &options) override;
+  int Step(Blackboard &b, const StepBudget &budget, StepUsage &used) override;
+  void HandleMapChanges(Blackboard &b, const Options &options,
+                        const std::vector<Point> &to_become_obstacles,
+                        const std::vector<Point> &to_remove_obstacles) override;
+  void HandleStartPointChange(Blackboard &b, const Options &options) override;
+
+ private:
+  // {邻接节点, 代价}
+  using Edge = std::pair<int, int>;
+
+  /////////////////////////////////
+  /// 抽象图 (预处理, 跨多次寻路)
+  /////////////////////////////////
+
+  // 簇的边长, 簇的行数和列数
+  int C = 16, CM = 0, CN = 0;
+  bool use_4directions = false;
+  // 抽象图对应的地图版本, 和 GRID_MAP.Version() 不同时需要重建
+  uint64_t graph_version = 0;
+  // 是否已经建好
+  bool graph_built = false;
+  // 抽象节点 (方格标号) => 邻接边
+  std::unordered_map<int, std::vector<Edge>> graph;
+  // 抽象节点被多少个入口引用, 为 0 时删除
+  std::unordered_map<int, int> node_refs;
+  // 每个簇内的抽象节点
+  std::vector<std::vector<int>> cluster_nodes;
+  // 簇 k 和右侧的簇之间 (vborders), 和下方的簇之间 (hborders) 的入口,
+  // 每一项是入口两侧的一对节点
+  std::vector<std::vector<std::pair<int, int>>> vborders, hborders;
+  // 8 方向时, 从簇 k 的右下角斜着跨到相邻簇的入口
+  std::vector<std::vector<std::pair<int, int>>> corners;
+
+  /////////////////////////////////
+  /// 单次寻路的状态
+  /////////////////////////////////
+
+  // 起点和终点接入抽象图的临时边
+  std::vector<Edge> s_edges;
+  std::unordered_map<int, int> t_edges;
+  // 抽象图上的 A*: 实际代价, 开放列表
+  StampedArray<int> g;
+  OpenList q;
+  // 0: 抽象图搜索中, 1: 细化中
+  int phase = 0;
+  // 抽象路径, 和已经细化的段数
+  std::vector<int> abstract_path;
+  std::size_t refined = 0;
+  // 簇内搜索的距离和来源
+  StampedArray<int> cdist, cfrom;
+  OpenList cq;
+  // 后继节点的缓存, 避免每次分配
+  std::vector<Edge> succ;
+
+  int clusterOf(int x) const {
+    return unpack_i(x) / C * CN + unpack_j(x) / C;
+  }
+  // 两点之间的启发距离
+  int distance(int x, int y) const;
+  // 在簇 k 内, 从 src 出发做 dijkstra, 结果在 cdist 和 cfrom 中.
+  // target 不是 -1 时, 到达 target 即停止
+  void searchInCluster(int src, int k, int target = -1);
+
+  // 重建整个抽象图
+  void buildGraph();
+  // 重建簇 k 和右侧 (vertical) 或者下方的簇之间的入口
+  void buildBorder(int k, bool vertical);
+  // 重建跨过簇 k 右下角的入口
+  void buildCorner(int k);
+  // 重建簇 k 的簇内边
+  void buildClusterEdges(int k);
+  void addNode(int x);
+  void removeNode(int x);
+  void addEdge(int u, int v, int w);
+  void removeEdge(int u, int v);
+  // 修复 changes 中的方格变化后受影响的入口和簇内边
+  void repairGraph(const std::vector<Point> &changes);
+
+  // 把起点和终点接入抽象图
+  void connectStartAndTarget();
+  // 抽象节点 x 的后继, 结果写入 succ
+  void successors(int x);
+  // 细化下一段抽象路径, 追加到黑板的 path 上
+  void refineNextSegment(Blackboard &b);
+};
+
+#endif
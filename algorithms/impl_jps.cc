@@ -0,0 +1,192 @@
+#include "impl_jps.h"
+
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+
+// 步进方向: -1, 0, 1
+static int sign(int v) { return (v > 0) - (v < 0); }
+
+void AlgorithmImplJPS::Setup(Blackboard &b, const Options &options) {
+  use_4directions = options.use_4directions;
+  if (use_4directions) spdlog::warn("JPS 只支持 8 方向, 4 方向时退化为 A*");
+  // 清理黑板
+  setupBlackboard(b);
+  // 建图
+  setupEdges(options.use_4directions);
+  // 清理 f, 到无穷大
+  resizeState(f, inf);
+  // 清理 queue, 并选用开放列表的实现
+  q.Reset(OpenListKindOf(options.open_list));
+  // 设置初始坐标和结束点
+  s = pack(options.start);
+  t = pack(options.target);
+  f[s] = 0;
+  from[s] = s;
+  q.push({distance(s, t), s});
+}
+
+int AlgorithmImplJPS::Step(Blackboard &b, const StepBudget &budget,
+                           StepUsage &used) {
+  StepMeter meter(budget, used);
+  while (!q.empty()) {
+    auto [_, x] = q.top();
+    q.pop();
+    int i = unpack_i(x), j = unpack_j(x);
+    // x 已经不算待扩展了, 恢复到 -1
+    b.exploring[i][j] = -1;
+    b.MarkDirty(x);
+    if (b.visited[i][j]) {
+      // 过期的重复元素 (lazy 删除)
+      b.stale_pops++;
+      continue;
+    }
+    // 访问数组中只有跳点, 用来展示 JPS 扩展了哪些点
+    b.visited[i][j] = true;
+    b.expansions++;
+    // 到达目标, 及时退出 (将 return 0)
+    if (t == x) break;
+    // 后继跳点进入待扩展
+    successors(x, succ);
+    for (auto y : succ) {
+      auto g = f[x] + distance(x, y);  // 跳点之间是直线或者斜线
+      if (f[y] > g) {
+        f[y] = g;
+        from[y] = x;
+        q.push({g + distance(y, t), y});
+        b.exploring[unpack_i(y)][unpack_j(y)] = g;
+        b.MarkDirty(y);
+      }
+    }
+    // 扩展完一个跳点, 预算用完时暂停
+    if (!meter.Spend()) return -1;
+  }
+  // 已经结束,需要计算最短路
+  if (from[t] == inf) return -2;  // 失败
+  buildShortestPathResult(b);
+  return 0;
+}
+
+int AlgorithmImplJPS::distance(int x, int y) const {
+  int di = abs(unpack_i(x) - unpack_i(y));
+  int dj = abs(unpack_j(x) - unpack_j(y));
+  if (use_4directions) return (di + dj) * COST_UNIT;
+  // 先走斜线, 再走直线
+  return std::min(di, dj) * DIAGONAL_COST + abs(di - dj) * COST_UNIT;
+}
+
+bool AlgorithmImplJPS::forced(int i, int j, int di, int dj) const {
+  if (di == 0)  // 水平: 上下是障碍物, 但是侧前方可以走
+    return (walkable(i + 1, j + dj) && !walkable(i + 1, j)) ||
+           (walkable(i - 1, j + dj) && !walkable(i - 1, j));
+  if (dj == 0)  // 竖直: 左右是障碍物, 但是侧前方可以走
+    return (walkable(i + di, j + 1) && !walkable(i, j + 1)) ||
+           (walkable(i + di, j - 1) && !walkable(i, j - 1));
+  // 斜向
+  return (walkable(i - di, j + dj) && !walkable(i - di, j)) ||
+         (walkable(i + di, j - dj) && !walkable(i, j - dj));
+}
+
+int AlgorithmImplJPS::jumpStraight(int i, int j, int di, int dj) {
+  while (true) {
+    i += di, j += dj;
+    if (!walkable(i, j)) return -1;
+    int x = pack(i, j);
+    if (x == t || forced(i, j, di, dj)) return x;
+  }
+}
+
+int AlgorithmImplJPS::jump(int x, int di, int dj) {
+  int i = unpack_i(x), j = unpack_j(x);
+  if (di == 0 || dj == 0) return jumpStraight(i, j, di, dj);
+  while (true) {
+    i += di, j += dj;
+    if (!walkable(i, j)) return -1;
+    int y = pack(i, j);
+    if (y == t || forced(i, j, di, dj)) return y;
+    // 斜向的每一步, 沿两个分量方向的直线上有跳点, 这一步也是跳点
+    if (jumpStraight(i, j, di, 0) != -1 || jumpStraight(i, j, 0, dj) != -1)
+      return y;
+  }
+}
+
+void AlgorithmImplJPS::prunedDirections(int x) {
+  dirs.clear();
+  int i = unpack_i(x), j = unpack_j(x);
+  // 起点没有父跳点, 8 个方向都要考察
+  if (from[x] == x) {
+    for (const auto &[_, d] : DIRECTIONS) dirs.push_back(d);
+    return;
+  }
+  int di = sign(i - unpack_i(from[x])), dj = sign(j - unpack_j(from[x]));
+  if (di != 0 && dj != 0) {
+    // 斜向: 自然邻居是两个分量方向和原方向
+    dirs.push_back({0, dj});
+    dirs.push_back({di, 0});
+    dirs.push_back({di, dj});
+    // 强制邻居
+    if (!walkable(i - di, j)) dirs.push_back({-di, dj});
+    if (!walkable(i, j - dj)) dirs.push_back({di, -dj});
+  } else if (di == 0) {
+    // 水平: 自然邻居只有原方向
+    dirs.push_back({0, dj});
+    if (!walkable(i + 1, j)) dirs.push_back({1, dj});
+    if (!walkable(i - 1, j)) dirs.push_back({-1, dj});
+  } else {
+    // 竖直
+    dirs.push_back({di, 0});
+    if (!walkable(i, j + 1)) dirs.push_back({di, 1});
+    if (!walkable(i, j - 1)) dirs.push_back({di, -1});
+  }
+}
+
+void AlgorithmImplJPS::successors(int x, std::vector<int> &out) {
+  out.clear();
+  // 4 方向不跳跃, 后继就是全部邻居
+  if (use_4directions) {
+    for (const auto &[_, y] : neighbors(x)) out.push_back(y);
+    return;
+  }
+  prunedDirections(x);
+  for (const auto &[di, dj] : dirs) {
+    int y = jump(x, di, dj);
+    if (y != -1) out.push_back(y);
+  }
+}
+
+void AlgorithmImplJPS::buildShortestPathResult(Blackboard &b) {
+  // 反向收集跳点
+  std::vector<int> points;
+  for (int x = t; x != s; x = from[x]) points.push_back(x);
+  points.push_back(s);
+  std::reverse(points.begin(), points.end());
+  // 相邻的两个跳点之间逐格补全
+  b.path.push_back({unpack_i(s), unpack_j(s)});
+  for (std::size_t k = 1; k < points.size(); k++) {
+    int i = unpack_i(points[k - 1]), j = unpack_j(points[k - 1]);
+    int i1 = unpack_i(points[k]), j1 = unpack_j(points[k]);
+    int di = sign(i1 - i), dj = sign(j1 - j);
+    while (i != i1 || j != j1) {
+      i += di, j += dj;
+      b.path.push_back({i, j});
+    }
+  }
+  b.isStopped = true;
+}
+
+void AlgorithmImplJPS::HandleMapChanges(
+    Blackboard &b, const Options &options,
+    const std::vector<Point> &to_become_obstacles,
+    const std::vector<Point> &to_remove_obstacles) {
+  if (to_become_obstacles.empty() && to_remove_obstacles.empty()) return;
+  // JPS 不支持增量计算, 只可以重新计算
+  spdlog::info("JPS 算法不支持增量计算, 将重新计算");
+  Setup(b, options);
+}
+
+void AlgorithmImplJPS::HandleStartPointChange(Blackboard &b,
+                                              const Options &options) {
+  // JPS 不支持增量计算, 只可以重新计算
+  spdlog::info("JPS 算法不支持增量计算, 将重新计算");
+  Setup(b, options);
+}
@@ -0,0 +1,59 @@
+#ifndef PATH_FINDING_VISUALIZER_ALGORITHM_JPS_H
+#define PATH_FINDING_VISUALIZER_ALGORITHM_JPS_H
+
+#include <vector>
+
+#include "algorithm_base.h"
+#include "open_list.h"
+
+// 算法实现 - JPS (Jump Point Search)
+// 在 8 方向均匀代价的网格上, 剪掉对称的邻居, 沿直线和斜线跳跃,
+// 只有跳点 (有强制邻居的点, 或者目标) 才进入开放列表.
+// 对角移动只要求目标格子不是障碍物 (和 GridMap::NeighborMask 一致).
+// 4 方向时不跳跃, 退化为普通的 A*.
+class AlgorithmImplJPS : public AlgorithmImplGraphBase {
+ public:
+  void Setup(Blackboard &b, const Options &options) override;
+  int Step(Blackboard &b, const StepBudget &budget, StepUsage &used) override;
+  void HandleMapChanges(Blackboard &b, const Options &options,
+                        const std::vector<Point> &to_become_obstacles,
+                        const std::vector<Point> &to_remove_obstacles) override;
+  void HandleStartPointChange(Blackboard &b, const Options &options) override;
+  bool SupportsTiledMap(const Options & /*options*/) const override {
+    return true;
+  }
+
+ protected:
+  // 起点到跳点的实际代价, 按标号存储
+  StampedArray<int> f;
+  OpenList q;
+  bool use_4directions = false;
+
+  // 是否可以站在 (i, j) 上
+  bool walkable(int i, int j) const {
+    return ValidatePoint(i, j) && !GRID_MAP.Get(i, j);
+  }
+  // 从 (i, j) 沿 (di, dj) 方向经过时, 它是否有强制邻居:
+  // 来时的侧面是障碍物, 但是绕过它可以走
+  bool forced(int i, int j, int di, int dj) const;
+  // 两点之间的启发距离, 8 方向是对角距离 (octile), 4 方向是曼哈顿距离
+  int distance(int x, int y) const;
+  // 从 x 出发沿 (di, dj) 方向跳跃, 返回遇到的跳点, 没有则返回 -1
+  virtual int jump(int x, int di, int dj);
+  // 从 x 出发沿直线方向 (di, dj) 跳跃, 同上
+  int jumpStraight(int i, int j, int di, int dj);
+  // 计算 x 的后继跳点, 结果写入 out
+  void successors(int x, std::vector<int> &out);
+  // 收集最短路, 跳点之间是直线或者斜线, 补全中间的格子
+  void buildShortestPathResult(Blackboard &b) override;
+
+ private:
+  // successors 的结果缓存, 避免每次分配
+  std::vector<int> succ;
+  // 剪枝后要跳跃的方向的缓存
+  std::vector<Point> dirs;
+  // 计算 x 剪枝后的方向, 父跳点是 from[x]
+  void prunedDirections(int x);
+};
+
+#endif
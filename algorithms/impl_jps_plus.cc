@@ -0,0 +1,164 @@
+#include "impl_jps_plus.h"
+
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+
+// 方向 (di, dj) 在 DIRECTIONS 中的下标, 按 [di + 1][dj + 1] 索引
+static const int DIRECTION_INDEX[3][3] = {{4, 2, 6}, {1, -1, 0}, {5, 3, 7}};
+
+static int directionIndex(int di, int dj) {
+  return DIRECTION_INDEX[di + 1][dj + 1];
+}
+
+void AlgorithmImplJPSPlus::Setup(Blackboard &b, const Options &options) {
+  // 4 方向时不跳跃, 不需要跳跃表
+  // 地图在 HandleMapChanges 之外被修改过 (比如重新加载), 需要重建
+  if (!options.use_4directions &&
+      (table.size() != static_cast<size_t>(GRID_MAP.Size()) * 8 ||
+       table_version != GRID_MAP.Version()))
+    buildTable();
+  AlgorithmImplJPS::Setup(b, options);
+}
+
+int32_t AlgorithmImplJPSPlus::computeEntry(int i, int j, int k) {
+  if (!walkable(i, j)) return 0;
+  const auto &[di, dj] = DIRECTIONS[k].second;
+  int i1 = i + di, j1 = j + dj;
+  if (!walkable(i1, j1)) return 0;
+  // 下一步是跳点: 有强制邻居, 或者斜向时沿两个分量方向的直线上有跳点
+  bool is_jump_point = forced(i1, j1, di, dj);
+  if (!is_jump_point && di != 0 && dj != 0)
+    is_jump_point = entry(i1, j1, directionIndex(di, 0)) > 0 ||
+                    entry(i1, j1, directionIndex(0, dj)) > 0;
+  if (is_jump_point) return 1;
+  // 否则在下一步的表项上多走一步
+  auto v = entry(i1, j1, k);
+  return v > 0 ? v + 1 : v - 1;
+}
+
+void AlgorithmImplJPSPlus::buildTable() {
+  auto t0 = std::chrono::steady_clock::now();
+  int M = GRID_MAP.Rows(), N = GRID_MAP.Cols();
+  table.assign(static_cast<size_t>(M) * N * 8, 0);
+  // 斜向的表项依赖直线的表项, 所以先算前 4 个方向.
+  // 每个方向上, 从下游往上游扫描, 下一步的表项总是先算好.
+  for (int k = 0; k < 8; k++) {
+    const auto &[di, dj] = DIRECTIONS[k].second;
+    for (int a = 0; a < M; a++) {
+      int i = di > 0 ? M - 1 - a : a;
+      for (int c = 0; c < N; c++) {
+        int j = dj > 0 ? N - 1 - c : c;
+        entry(i, j, k) = computeEntry(i, j, k);
+      }
+    }
+  }
+  table_version = GRID_MAP.Version();
+  auto ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - t0)
+                .count();
+  spdlog::info("JPS+ 预处理耗时 {:.1f}ms, 跳跃表占用 {:.1f}MB", ms,
+               table.size() * sizeof(int32_t) / 1048576.0);
+}
+
+int AlgorithmImplJPSPlus::propagate(int i, int j, int k,
+                                    std::vector<Point> *changed) {
+  const auto &[di, dj] = DIRECTIONS[k].second;
+  int n = 0;
+  // 上游的表项只依赖下一步的表项, 不变时就可以停止
+  for (; ValidatePoint(i, j); i -= di, j -= dj) {
+    auto v = computeEntry(i, j, k);
+    auto &e = entry(i, j, k);
+    if (v == e) break;
+    e = v;
+    n++;
+    if (changed) changed->push_back({i, j});
+  }
+  return n;
+}
+
+int AlgorithmImplJPSPlus::repairTable(const std::vector<Point> &changes) {
+  // 表项只在本地依赖距离 2 以内的方格 (下一步, 和它的强制邻居判断),
+  // 其余的影响都沿着行, 列和斜线由 propagate 传递到上游.
+  std::vector<Point> seeds;
+  for (const auto &[ci, cj] : changes)
+    for (int i = ci - 2; i <= ci + 2; i++)
+      for (int j = cj - 2; j <= cj + 2; j++)
+        if (ValidatePoint(i, j)) seeds.push_back({i, j});
+  int n = 0;
+  // 先修复直线的表项, 并记录修改过的方格
+  std::vector<Point> straight_changed;
+  for (int k = 0; k < 4; k++)
+    for (const auto &[i, j] : seeds) n += propagate(i, j, k, &straight_changed);
+  // 斜向的表项还依赖下一步的直线表项
+  for (int k = 4; k < 8; k++) {
+    const auto &[di, dj] = DIRECTIONS[k].second;
+    for (const auto &[i, j] : seeds) n += propagate(i, j, k, nullptr);
+    for (const auto &[i, j] : straight_changed)
+      n += propagate(i - di, j - dj, k, nullptr);
+  }
+  return n;
+}
+
+void AlgorithmImplJPSPlus::HandleMapChanges(
+    Blackboard &b, const Options &options,
+    const std::vector<Point> &to_become_obstacles,
+    const std::vector<Point> &to_remove_obstacles) {
+  if (to_become_obstacles.empty() && to_remove_obstacles.empty()) return;
+  // 跳跃表对应修改之前的地图版本时, 只修复受影响的表项.
+  // 每个方格的修改 (GridMap::Set) 让地图版本加一, 版本对不上时说明
+  // 还有没经过这里的修改 (比如修改时在用别的算法), 留给 Setup 重建
+  uint64_t edits = to_become_obstacles.size() + to_remove_obstacles.size();
+  bool is_fresh = table.size() == static_cast<size_t>(GRID_MAP.Size()) * 8 &&
+                  table_version + edits == GRID_MAP.Version();
+  if (!table.empty() && !is_fresh)
+    spdlog::info("JPS+ 跳跃表已经过期, 将重建");
+  if (is_fresh) {
+    auto t0 = std::chrono::steady_clock::now();
+    auto changes = to_become_obstacles;
+    changes.insert(changes.end(), to_remove_obstacles.begin(),
+                   to_remove_obstacles.end());
+    int n = repairTable(changes);
+    table_version = GRID_MAP.Version();
+    auto us = std::chrono::duration<double, std::micro>(
+                  std::chrono::steady_clock::now() - t0)
+                  .count();
+    spdlog::info("JPS+ 增量修复了 {} 个表项, 耗时 {:.1f}us", n, us);
+  }
+  // 寻路本身重新开始
+  AlgorithmImplJPS::HandleMapChanges(b, options, to_become_obstacles,
+                                     to_remove_obstacles);
+}
+
+int AlgorithmImplJPSPlus::jump(int x, int di, int dj) {
+  int i = unpack_i(x), j = unpack_j(x);
+  auto v = table[static_cast<size_t>(x) * 8 + directionIndex(di, dj)];
+  // reach 是这个方向上可以走的步数, best 是最近的跳点的步数
+  int reach = v > 0 ? v : -v;
+  int best = v > 0 ? v : inf;
+  // 和目标相关的跳点不能预处理, 需要单独判断
+  int ti = unpack_i(t), tj = unpack_j(t);
+  if (di == 0 || dj == 0) {
+    // 目标在这条直线上
+    int kt = -1;
+    if (di == 0 && ti == i) kt = (tj - j) * dj;
+    if (dj == 0 && tj == j) kt = (ti - i) * di;
+    if (kt > 0 && kt <= reach) best = std::min(best, kt);
+  } else {
+    // 斜线走到目标所在的行 (或列) 的那一步,
+    // 如果从那里沿直线可以直接走到目标, 那一步也是跳点
+    int kr = (ti - i) * di;
+    if (kr > 0 && kr <= reach && kr < best) {
+      int yj = j + kr * dj, d = (tj - yj) * dj;
+      if (d == 0 || (d > 0 && abs(entry(ti, yj, directionIndex(0, dj))) >= d))
+        best = kr;
+    }
+    int kc = (tj - j) * dj;
+    if (kc > 0 && kc <= reach && kc < best) {
+      int yi = i + kc * di, d = (ti - yi) * di;
+      if (d == 0 || (d > 0 && abs(entry(yi, tj, directionIndex(di, 0))) >= d))
+        best = kc;
+    }
+  }
+  return best < inf ? pack(i + best * di, j + best * dj) : -1;
+}
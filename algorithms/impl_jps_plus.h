@@ -0,0 +1,49 @@
+#ifndef PATH_FINDING_VISUALIZER_ALGORITHM_JPS_PLUS_H
+#define PATH_FINDING_VISUALIZER_ALGORITHM_JPS_PLUS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "impl_jps.h"
+
+// 算法实现 - JPS+
+// 预处理每个方格沿 8 个方向到下一个跳点 (或者障碍物) 的距离,
+// 寻路时跳跃只需要查表, 不需要逐格扫描. 找到的跳点和 JPS 完全一致.
+// 地图变化时只修复经过变化方格的行, 列和斜线上的表项.
+class AlgorithmImplJPSPlus : public AlgorithmImplJPS {
+ public:
+  void Setup(Blackboard &b, const Options &options) override;
+  void HandleMapChanges(Blackboard &b, const Options &options,
+                        const std::vector<Point> &to_become_obstacles,
+                        const std::vector<Point> &to_remove_obstacles) override;
+  // 跳跃表的预处理要遍历整张地图
+  bool SupportsTiledMap(const Options & /*options*/) const override {
+    return false;
+  }
+
+ protected:
+  int jump(int x, int di, int dj) override;
+
+ private:
+  // 跳跃表, table[x * 8 + k] 是方格 x 沿 DIRECTIONS[k] 的跳跃距离:
+  // 正数 d 表示走 d 步到达跳点;
+  // 0 或者负数 -d 表示走 d 步之后遇到障碍物或者边界, 途中没有跳点.
+  // 障碍物方格的表项都是 0
+  std::vector<int32_t> table;
+  // 跳跃表对应的地图版本, 和 GRID_MAP.Version() 不同时需要重建
+  uint64_t table_version = 0;
+
+  // 表项的引用
+  int32_t &entry(int i, int j, int k) { return table[pack(i, j) * 8 + k]; }
+  // 按照下游的表项, 计算方格 (i,j) 沿 DIRECTIONS[k] 的表项
+  int32_t computeEntry(int i, int j, int k);
+  // 重建整个跳跃表
+  void buildTable();
+  // 修复 changes 中的方格变化后受影响的表项, 返回修改的表项数
+  int repairTable(const std::vector<Point> &changes);
+  // 从方格 (i,j) 开始沿 DIRECTIONS[k] 的反方向重新计算表项, 直到不再变化
+  // 修改过的方格追加到 changed
+  int propagate(int i, int j, int k, std::vector<Point> *changed);
+};
+
+#endif
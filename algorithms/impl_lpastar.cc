@@ -2,16 +2,22 @@
 
 #include <spdlog/spdlog.h>
 
-#include <bitset>
+#include <vector>
 
 int AlgorithmImplLPAStar::h(int x) {
+  // 目标点不变, 每个点只需要计算一次
+  if (hs[x] >= 0) return hs[x];
   // 方格内的坐标
   auto ti = unpack_i(t), tj = unpack_j(t);
   auto xi = unpack_i(x), xj = unpack_j(x);
   // 曼哈顿
-  if (heuristic_method == 1) return (abs(ti - xi) + abs(tj - xj)) * COST_UNIT;
+  if (heuristic_method == 1)
+    return hs[x] = (abs(ti - xi) + abs(tj - xj)) * COST_UNIT;
+  // 地标的三角不等式下界
+  if (heuristic_method == 3) return hs[x] = landmarks.Estimate(x, t);
   // 欧式距离
-  return std::floor(std::hypot(abs(ti - xi), abs(tj - xj))) * COST_UNIT;
+  return hs[x] =
+             std::floor(std::hypot(abs(ti - xi), abs(tj - xj))) * COST_UNIT;
 }
 
 AlgorithmImplLPAStar::K AlgorithmImplLPAStar::k(int x) {
@@ -20,29 +26,32 @@ AlgorithmImplLPAStar::K AlgorithmImplLPAStar::k(int x) {
 }
 
 void AlgorithmImplLPAStar::init() {
-  memset(g, 0x3f, sizeof g);
-  memset(rhs, 0x3f, sizeof rhs);
+  g.assign(GRID_MAP.Size(), inf);
+  rhs.assign(GRID_MAP.Size(), inf);
+  hs.assign(GRID_MAP.Size(), -1);
   rhs[s] = 0;
-  q.insert({k(s), s});
+  q.Push(s, k(s));
 }
 
 void AlgorithmImplLPAStar::update(int x) {
   // 其实点不可更新, g[s] 和 rhs[s] 恒等于 0
   if (x == s) return;
-  // 从队列中删除
-  q.erase(k(x));
   // 根据 x 的前继节点的实际代价 g, 加上边权 w, 取最小.
   // 来获取 x 处的新代价 rhs
   rhs[x] = inf;
   for (auto [y, w] : pred[x]) rhs[x] = std::min(rhs[x], g[y] + w);
-  // 如果 x 的 g 和 rhs 没有对齐, 则重新加入队列等待更新
-  if (g[x] != rhs[x]) q.insert({k(x), x});
+  // 如果 x 的 g 和 rhs 没有对齐, 则加入队列 (或者修改 key) 等待更新
+  // 否则从队列中删除
+  if (g[x] != rhs[x])
+    q.Push(x, k(x));
+  else
+    q.Remove(x);
 }
 
 int AlgorithmImplLPAStar::collect(std::vector<int> &path) {
   path.push_back(t);
   // st 用来判环, 如果检测到, 则即时终止, 以防死循环
-  std::bitset<n> st;
+  std::vector<bool> st(GRID_MAP.Size());
   int x = t;
   while (x != s) {
     if (st[x]) {
@@ -74,14 +83,7 @@ int AlgorithmImplLPAStar::collect(std::vector<int> &path) {
 
 void AlgorithmImplLPAStar::add_obstacle(int i, int j) {
   int x = pack(i, j);
-  // 到达 x 的边权全部无穷大
-  for (auto &[y, w] : pred[x]) w = inf;
-
-  // x 到达后继邻居的边权全部无穷大
-  for (auto y : succ[x])
-    for (auto &[x1, w] : pred[y])
-      if (x1 == x) w = inf;
-
+  blockEdges(x);
   // update x 和 后继邻居
   // 原则是:  update 边权有变化的边的末端节点
   update(x);
@@ -90,31 +92,7 @@ void AlgorithmImplLPAStar::add_obstacle(int i, int j) {
 
 void AlgorithmImplLPAStar::remove_obstacle(int i, int j) {
   int x = pack(i, j);
-
-  // 到达 x 的边权全部恢复
-  for (auto &[y, w] : pred[x]) {
-    int i1 = unpack_i(y), j1 = unpack_j(y);
-    int di = i - i1, dj = j - j1;
-    if (di != 0 && dj != 0) {  // 斜边邻居
-      w = DIAGONAL_COST;
-    } else {  // 水平竖直邻居
-      w = COST_UNIT;
-    }
-  }
-  // x 到达后继邻居的边权全部恢复
-  for (auto y : succ[x]) {  // 对每个 x 的后继 y
-    int i1 = unpack_i(y), j1 = unpack_j(y);
-    int di = i - i1, dj = j - j1;
-    for (auto &[x1, w] : pred[y])
-      // 找到 y 的前继 x 的边权 w
-      if (x1 == x) {
-        if (di != 0 && dj != 0) {  // 斜边邻居
-          w = DIAGONAL_COST;
-        } else {  // 水平竖直邻居
-          w = COST_UNIT;
-        }
-      }
-  }
+  restoreEdges(x);
   // update x 和 后继邻居
   // 原则是:  update 边权有变化的边的末端节点
   update(x);
@@ -123,7 +101,7 @@ void AlgorithmImplLPAStar::remove_obstacle(int i, int j) {
 
 // 支持增量计算
 void AlgorithmImplLPAStar::HandleMapChanges(
-    Blackboard &b, const Options &options,
+    Blackboard &b, const Options & /*options*/,
     const std::vector<Point> &to_become_obstacles,
     const std::vector<Point> &to_remove_obstacles) {
   if (to_become_obstacles.empty() && to_remove_obstacles.empty()) return;
@@ -138,9 +116,20 @@ void AlgorithmImplLPAStar::HandleMapChanges(
   for (const auto &p : to_remove_obstacles) {
     remove_obstacle(p.first, p.second);
   }
+  // 地标的距离表不立即重算 (下次 Setup 时再按新地图重算).
+  // 新增障碍物时旧的表仍然是下界; 移除障碍物时需要把距离向下修正,
+  // 启发函数因此变小, 队列中的键值要重新计算
+  if (heuristic_method == 3 && landmarks.Relax(to_remove_obstacles) > 0)
+    rekey();
   spdlog::info("LAPStar 增量修改完毕");
 }
 
+void AlgorithmImplLPAStar::rekey() {
+  hs.assign(GRID_MAP.Size(), -1);
+  for (int x = 0; x < GRID_MAP.Size(); x++)
+    if (q.Contains(x)) q.Push(x, k(x));
+}
+
 void AlgorithmImplLPAStar::HandleStartPointChange(Blackboard &b,
                                                   const Options &options) {
   spdlog::info("LAPStar 不支持动态变更起始点, 将重新计算");
@@ -157,6 +146,10 @@ void AlgorithmImplLPAStar::Setup(Blackboard &b, const Options &options) {
   if (options.astar_heuristic_method == "euclidean") {
     heuristic_method = 2;
     spdlog::info("LPAStar 选用欧式距离");
+  } else if (options.astar_heuristic_method == "landmarks") {
+    heuristic_method = 3;
+    spdlog::info("LPAStar 选用地标启发");
+    landmarks.Prepare(options.use_4directions, options.landmark_count);
   } else {
     heuristic_method = 1;
     spdlog::info("LPAStar 选用曼哈顿距离");
@@ -166,33 +159,10 @@ void AlgorithmImplLPAStar::Setup(Blackboard &b, const Options &options) {
   // 清理黑板
   setupBlackboard(b);
   // 建图
-  pred.clear();
-  succ.clear();
-  pred.resize(n);
-  succ.resize(n);
-  // 初始化 pred 和 succ
-  for (int i = 0; i < M; i++) {
-    for (int j = 0; j < N; j++) {
-      int x = pack(i, j);
-      int di_max = options.use_4directions ? 4 : 8;
-      for (int di = 0; di < di_max; di++) {
-        const auto &[w, d] = DIRECTIONS[di];
-        auto i1 = i + d.first, j1 = j + d.second;
-        auto y = pack(i1, j1);
-        if (ValidatePoint(i1, j1)) {
-          // 现在考虑的边 (x => y)
-          // 后继
-          succ[x].push_back(y);
-          // 前继, 从障碍物出发或者到达障碍物都算作无穷大的边权
-          pred[y].push_back(
-              {x, (GRID_MAP[i][j] || GRID_MAP[i1][j1]) ? inf : w});
-        }
-      }
-    }
-  }
+  setupGraph(options.use_4directions);
 
   // 清理 q
-  q.clear();
+  q.Reset(GRID_MAP.Size());
   // 设置初始坐标
   s = pack(options.start);
   // 设置结束点
@@ -201,47 +171,56 @@ void AlgorithmImplLPAStar::Setup(Blackboard &b, const Options &options) {
   init();
 }
 
-int AlgorithmImplLPAStar::Update(Blackboard &b) {
-  while (q.size()) {
-    auto it = q.begin();
-    if ((!force_stop_until_target) && it->first >= k(t) && rhs[t] == g[t])
-      break;
-
-    // 弹出队头
-    int x = it->second;
-    q.erase(it);
-
-    int i = unpack_i(x), j = unpack_j(x);
-    b.visited[unpack_i(x)][unpack_j(x)] = true;
-
-    if (g[x] > rhs[x]) {
-      // 局部过一致
-      g[x] = rhs[x];
-    } else {
-      // 局部欠一致, 通常说明新增了障碍物
-      g[x] = inf;
-      update(x);
-    }
-    // 向后继节点传播, 更新邻域
-    for (auto y : succ[x]) {
-      update(y);
-      b.exploring[unpack_i(y)][unpack_j(y)] = g[y];
-    }
+int AlgorithmImplLPAStar::Step(Blackboard &b, const StepBudget &budget,
+                               StepUsage &used) {
+  StepMeter meter(budget, used);
+  std::vector<int> path;
+  while (true) {
+    while (!q.Empty()) {
+      if ((!force_stop_until_target) && q.TopKey() >= k(t) && rhs[t] == g[t])
+        break;
+
+      // 弹出队头
+      int x = q.Top();
+      q.Pop();
+
+      int i = unpack_i(x), j = unpack_j(x);
+      b.visited[i][j] = true;
+      b.expansions++;
+      b.MarkDirty(x);
+
+      if (g[x] > rhs[x]) {
+        // 局部过一致
+        g[x] = rhs[x];
+      } else {
+        // 局部欠一致, 通常说明新增了障碍物
+        g[x] = inf;
+        update(x);
+      }
+      // 向后继节点传播, 更新邻域
+      for (auto y : succ[x]) {
+        update(y);
+        b.exploring[unpack_i(y)][unpack_j(y)] = g[y];
+        b.MarkDirty(y);
+      }
 
-    // 无论如何, 已经扩散到目标, 都可以终止
-    if (x == t) break;
+      // 已经扩散到目标, 并且目标是局部一致的, 可以终止.
+      // 目标局部欠一致时 (路径变长了), g[t] 先被重置为无穷大,
+      // 此时 g[t] == rhs[t] == inf 并不代表不可达, 需要继续传播
+      if (x == t && g[t] == rhs[t] && g[t] < inf) break;
 
-    // 每一次 Update 都只考察一个点, 不算结束
-    return -1;
-  }
+      // 考察完一个点, 预算用完时暂停
+      if (!meter.Spend()) return -1;
+    }
 
-  // 已经结束, 需要计算最短路
-  if (g[t] >= inf) return -2;  // 失败
+    // 已经结束, 需要计算最短路
+    if (g[t] >= inf) return -2;  // 失败
 
-  std::vector<int> path;
-  if (collect(path) != 0)
-    // 收集失败, 继续重试 Update
-    return -1;
+    path.clear();
+    if (collect(path) == 0) break;
+    // 收集失败, 继续传播
+    if (!meter.Spend()) return -1;
+  }
   // 收集成功, 重置 force_stop_until_target
   force_stop_until_target = false;
   // 输出到 blackboard
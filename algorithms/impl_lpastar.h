@@ -1,15 +1,17 @@
 #ifndef PATH_FINDING_VISUALIZER_ALGORITHM_LPASTAR_H
 #define PATH_FINDING_VISUALIZER_ALGORITHM_LPASTAR_H
 
-#include <map>
+#include <tuple>
 
 #include "algorithm_base.h"
+#include "indexed_heap.h"
+#include "landmarks.h"
 
 // 算法实现 - LPAstar
-class AlgorithmImplLPAStar : public AlgorithmImplBase {
+class AlgorithmImplLPAStar : public AlgorithmImplIncrementalBase {
  public:
   void Setup(Blackboard &b, const Options &options) override;
-  int Update(Blackboard &b) override;
+  int Step(Blackboard &b, const StepBudget &budget, StepUsage &used) override;
   void HandleMapChanges(Blackboard &b, const Options &options,
                         const std::vector<Point> &to_become_obstacles,
                         const std::vector<Point> &to_remove_obstacles) override;
@@ -17,28 +19,27 @@ class AlgorithmImplLPAStar : public AlgorithmImplBase {
 
  private:
   int heuristic_weight = 1;
-  int heuristic_method = 1;  // 1 曼哈顿, 2 欧式
+  int heuristic_method = 1;  // 1 曼哈顿, 2 欧式, 3 地标
+  // 地标启发的距离表, 跨多次寻路复用
+  LandmarkHeuristic landmarks;
   // 默认情况下, 传播是按照估价终止的
   // 如果这个 force_stop_until_target 设置到 true
   // 那么会强制传播到目标才终止(或者q空的时候).
   // 这个用来预防不良的, 高估的估价函数 (比如8方向的情况下的曼哈顿函数)
   bool force_stop_until_target = false;
-  // { 标号, 边权 }
-  using P = std::pair<int, int>;
   // { 键值k1, 键值k2, 标号 }
   using K = std::tuple<int, int, int>;
-  // 前继 {标号, 边权}
-  std::vector<std::vector<P>> pred;
-  // 后继
-  std::vector<std::vector<int>> succ;
 
   // g 值: 起点到当前点的实际代价 (旧值)
   // rhs 值: 起点到当前点的实际代价的临时值, 由前继节点更新而来
-  int g[n], rhs[n];
-  // 优先级队列 (因为要支持 update 操作, 所以用 map)
-  std::map<K, int> q;
+  // 按标号存储, 大小是地图的节点总数
+  std::vector<int> g, rhs;
+  // 启发函数值的缓存, -1 表示还没有计算
+  std::vector<int> hs;
+  // 优先级队列, 要支持修改和删除任意节点, 所以用带索引的堆
+  IndexedHeap<K> q;
 
-  // 启发函数
+  // 启发函数 (带缓存)
   int h(int x);
   // 计算 queue 的 key 的函数
   K k(int x);
@@ -53,6 +54,8 @@ class AlgorithmImplLPAStar : public AlgorithmImplBase {
   void add_obstacle(int i, int j);
   // 清理障碍物
   void remove_obstacle(int i, int j);
+  // 启发函数变化后, 清空缓存并重新计算队列中全部节点的键值
+  void rekey();
 };
 
 #endif
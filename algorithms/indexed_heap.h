@@ -0,0 +1,96 @@
+#ifndef PATH_FINDING_VISUALIZER_ALGORITHM_INDEXED_HEAP_H
+#define PATH_FINDING_VISUALIZER_ALGORITHM_INDEXED_HEAP_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include "../base.h"
+
+// 带索引的 D 叉小根堆, 元素是节点标号, 按 Key 排序.
+// 记录每个节点在堆中的位置, 所以可以 O(log n) 地修改任意节点的 key
+// (变大或者变小) 或者删除它, 而且不需要分配内存.
+// D = 4 时树高减半, 而且一个节点的孩子们通常在同一个缓存行上.
+template <typename Key, int D = 4>
+class IndexedHeap {
+ public:
+  // 清空, 节点标号的范围是 [0, n), 尺寸不变时是 O(1) 的
+  void Reset(int n) {
+    heap.clear();
+    pos.Resize(n, -1);
+  }
+  bool Contains(int x) const { return pos.Get(x) >= 0; }
+  // 插入节点 x, 如果已经在堆中, 则修改它的 key
+  void Push(int x, const Key &key) {
+    int i = pos[x];
+    if (i < 0) {
+      i = heap.size();
+      heap.push_back({key, x});
+      pos[x] = i;
+      return siftUp(i);
+    }
+    bool up = key < heap[i].first;
+    heap[i].first = key;
+    up ? siftUp(i) : siftDown(i);
+  }
+  // 删除节点 x, 不在堆中则什么都不做
+  void Remove(int x) {
+    int i = pos[x];
+    if (i < 0) return;
+    pos[x] = -1;
+    int last = heap.size() - 1;
+    if (i != last) {
+      bool up = heap[last].first < heap[i].first;
+      place(i, heap[last]);
+      heap.pop_back();
+      up ? siftUp(i) : siftDown(i);
+    } else {
+      heap.pop_back();
+    }
+  }
+  // 堆顶的节点和它的 key
+  int Top() const { return heap[0].second; }
+  const Key &TopKey() const { return heap[0].first; }
+  void Pop() { Remove(heap[0].second); }
+  bool Empty() const { return heap.empty(); }
+  int Size() const { return heap.size(); }
+
+ private:
+  // { key, 节点标号 }
+  std::vector<std::pair<Key, int>> heap;
+  // 节点在 heap 中的位置, 不在堆中是 -1
+  StampedArray<int> pos;
+
+  void place(int i, const std::pair<Key, int> &e) {
+    heap[i] = e;
+    pos[e.second] = i;
+  }
+  void siftUp(int i) {
+    auto e = heap[i];
+    while (i > 0) {
+      int p = (i - 1) / D;
+      if (!(e.first < heap[p].first)) break;
+      place(i, heap[p]);
+      i = p;
+    }
+    place(i, e);
+  }
+  void siftDown(int i) {
+    auto e = heap[i];
+    int n = heap.size();
+    while (true) {
+      // 找到最小的孩子
+      int c = i * D + 1;
+      if (c >= n) break;
+      int end = std::min(c + D, n);
+      for (int k = c + 1; k < end; k++)
+        if (heap[k].first < heap[c].first) c = k;
+      if (!(heap[c].first < e.first)) break;
+      place(i, heap[c]);
+      i = c;
+    }
+    place(i, e);
+  }
+};
+
+#endif
@@ -0,0 +1,167 @@
+#include "landmarks.h"
+
+#include <spdlog/spdlog.h>
+
+#include <bit>
+#include <chrono>
+
+#include "open_list.h"
+
+void LandmarkHeuristic::Prepare(bool use_4directions, int count) {
+  count = std::max(1, count);
+  if (built && this->use_4directions == use_4directions &&
+      requested == count && table_version == GRID_MAP.Version() &&
+      dist.size() == static_cast<size_t>(GRID_MAP.Size()) * k)
+    return;
+  this->use_4directions = use_4directions;
+  requested = count;
+  build();
+}
+
+int LandmarkHeuristic::geometric(int x, int y) const {
+  int di = abs(unpack_i(x) - unpack_i(y));
+  int dj = abs(unpack_j(x) - unpack_j(y));
+  if (use_4directions) return (di + dj) * COST_UNIT;
+  // 先走斜线, 再走直线
+  return std::min(di, dj) * DIAGONAL_COST + abs(di - dj) * COST_UNIT;
+}
+
+int LandmarkHeuristic::Estimate(int x, int y) const {
+  int h = geometric(x, y);
+  const int32_t *dx = dist.data() + static_cast<size_t>(x) * k;
+  const int32_t *dy = dist.data() + static_cast<size_t>(y) * k;
+  for (int l = 0; l < k; l++) {
+    // 有一端从地标不可达时, 这个地标给不出下界
+    if (dx[l] >= inf || dy[l] >= inf) continue;
+    h = std::max(h, abs(dx[l] - dy[l]));
+  }
+  return h;
+}
+
+int LandmarkHeuristic::propagate(
+    int l, const std::vector<std::pair<int, int>> &seeds) {
+  unsigned direction_mask = use_4directions ? 0x0f : 0xff;
+  int offsets[8];
+  for (int d = 0; d < 8; d++)
+    offsets[d] = pack(DIRECTIONS[d].second.first, DIRECTIONS[d].second.second);
+  OpenList q;
+  q.Reset(OpenList::Kind::Bucket);
+  for (const auto &p : seeds) q.push(p);
+  int n = 0;
+  while (!q.empty()) {
+    auto [d, x] = q.top();
+    q.pop();
+    if (d > at(x, l)) continue;  // 过期的重复元素
+    for (unsigned mask = GRID_MAP.NeighborMask(x) & direction_mask; mask;
+         mask &= mask - 1) {
+      int dk = std::countr_zero(mask);
+      int y = x + offsets[dk];
+      auto &dy = at(y, l);
+      if (dy > d + DIRECTIONS[dk].first) {
+        dy = d + DIRECTIONS[dk].first;
+        n++;
+        q.push({dy, y});
+      }
+    }
+  }
+  return n;
+}
+
+int LandmarkHeuristic::largestComponentCell(
+    const std::vector<int> &free_cells) {
+  unsigned direction_mask = use_4directions ? 0x0f : 0xff;
+  std::vector<bool> seen(GRID_MAP.Size(), false);
+  std::vector<int> stack;
+  int best = free_cells[0], best_size = 0;
+  for (auto x0 : free_cells) {
+    if (seen[x0]) continue;
+    seen[x0] = true;
+    stack.push_back(x0);
+    int size = 0;
+    while (!stack.empty()) {
+      int x = stack.back();
+      stack.pop_back();
+      size++;
+      for (unsigned mask = GRID_MAP.NeighborMask(x) & direction_mask; mask;
+           mask &= mask - 1) {
+        const auto &[di, dj] = DIRECTIONS[std::countr_zero(mask)].second;
+        int y = pack(unpack_i(x) + di, unpack_j(x) + dj);
+        if (!seen[y]) {
+          seen[y] = true;
+          stack.push_back(y);
+        }
+      }
+    }
+    if (size > best_size) best = x0, best_size = size;
+  }
+  return best;
+}
+
+void LandmarkHeuristic::build() {
+  auto t0 = std::chrono::steady_clock::now();
+  GRID_MAP.PrepareNeighborMasks();
+  int n = GRID_MAP.Size();
+  std::vector<int> free_cells;
+  for (int x = 0; x < n; x++)
+    if (!GRID_MAP.Get(unpack_i(x), unpack_j(x))) free_cells.push_back(x);
+  k = std::min<int>(requested, free_cells.size());
+  landmarks.clear();
+  dist.assign(static_cast<size_t>(n) * k, inf);
+  if (k > 0) {
+    // 计算地标 l (方格 x) 的距离
+    auto compute = [&](int l, int x) {
+      for (int y = 0; y < n; y++) at(y, l) = inf;
+      at(x, l) = 0;
+      std::vector<std::pair<int, int>> seeds = {{0, x}};
+      propagate(l, seeds);
+    };
+    // 最远点选择: 每个新的地标都是离已有的地标最远的方格.
+    // 第一个地标是离最大的连通块中任意一个方格最远的方格, 先借用第 0 列计算.
+    // 只在这个连通块中选择, 以免地标都落在零散的小块中
+    compute(0, largestComponentCell(free_cells));
+    for (int l = 0; l < k; l++) {
+      int best = -1, best_d = -1;
+      for (auto x : free_cells) {
+        int d = inf;
+        for (int j = 0; j < std::max(l, 1); j++) d = std::min(d, at(x, j));
+        if (d < inf && d > best_d) best = x, best_d = d;
+      }
+      landmarks.push_back(best);
+      compute(l, best);
+    }
+  }
+  table_version = GRID_MAP.Version();
+  built = true;
+  auto ms = std::chrono::duration<double, std::milli>(
+                std::chrono::steady_clock::now() - t0)
+                .count();
+  spdlog::info("地标启发: 预处理 {} 个地标耗时 {:.1f}ms, 距离表占用 {:.1f}MB",
+               k, ms, dist.size() * sizeof(int32_t) / 1048576.0);
+}
+
+int LandmarkHeuristic::Relax(const std::vector<Point> &to_remove_obstacles) {
+  if (!built || dist.size() != static_cast<size_t>(GRID_MAP.Size()) * k)
+    return 0;
+  unsigned direction_mask = use_4directions ? 0x0f : 0xff;
+  int n = 0;
+  for (int l = 0; l < k; l++) {
+    // 新的方格的距离取自邻居, 然后从这里向外传播
+    std::vector<std::pair<int, int>> seeds;
+    for (const auto &[i, j] : to_remove_obstacles) {
+      int x = pack(i, j);
+      for (unsigned mask = GRID_MAP.NeighborMask(x) & direction_mask; mask;
+           mask &= mask - 1) {
+        int dk = std::countr_zero(mask);
+        const auto &[w, d] = DIRECTIONS[dk];
+        int y = pack(i + d.first, j + d.second);
+        if (at(x, l) > at(y, l) + w) {
+          at(x, l) = at(y, l) + w;
+          n++;
+        }
+      }
+      if (at(x, l) < inf) seeds.push_back({at(x, l), x});
+    }
+    n += propagate(l, seeds);
+  }
+  return n;
+}
@@ -0,0 +1,57 @@
+#ifndef PATH_FINDING_VISUALIZER_ALGORITHM_LANDMARKS_H
+#define PATH_FINDING_VISUALIZER_ALGORITHM_LANDMARKS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "../base.h"
+
+// 地标启发 (ALT, A* + Landmarks + Triangle inequality)
+// 选 k 个地标, 预处理每个地标到全部方格的精确距离 d.
+// 由三角不等式, 对任意地标 L, |d(L,y) - d(L,x)| 都是 x 到 y 的距离的下界,
+// 取全部地标中最大的下界 (和几何距离的下界中的最大者) 作为启发函数.
+// 在迷宫一类的地图上, 它比几何距离紧得多.
+//
+// 只要表中的 d 对当前地图的每条边 (u,v) 满足 |d(u) - d(v)| <= w(u,v),
+// 这个启发就是可采纳而且一致的:
+//   新增障碍物只删除边, 表仍然满足条件, 只是变得松一些;
+//   移除障碍物会新增边, 需要 Relax 从新的方格开始把距离向下传播.
+// 所以地图变化时不需要立即重算, 下次 Prepare 时再按新的地图重算精确值.
+class LandmarkHeuristic {
+ public:
+  // 为当前的 GRID_MAP 准备距离表.
+  // 地图版本, 方向数或者地标数变化时重算, 否则是 O(1) 的
+  void Prepare(bool use_4directions, int count);
+  // x 到 y 的距离的下界
+  int Estimate(int x, int y) const;
+  // 移除障碍物之后, 修正距离表以保持上述条件, 返回修改的表项数.
+  // 表仍然标记为过期, 下次 Prepare 时重算
+  int Relax(const std::vector<Point> &to_remove_obstacles);
+
+ private:
+  // 地标的数量, 和要求的数量 (可通行的方格太少时 k 会更小)
+  int k = 0, requested = 0;
+  bool use_4directions = false;
+  // 距离表对应的地图版本, 和 GRID_MAP.Version() 不同时需要重算
+  uint64_t table_version = 0;
+  bool built = false;
+  // 地标的标号
+  std::vector<int> landmarks;
+  // dist[x * k + l] 是地标 l 到方格 x 的距离, 不可达是 inf.
+  // 同一个方格的 k 个距离放在一起, Estimate 只需要读两段连续的内存
+  std::vector<int32_t> dist;
+
+  // 地标 l 到方格 x 的距离
+  int32_t &at(int x, int l) { return dist[static_cast<size_t>(x) * k + l]; }
+  // 几何距离的下界, 8 方向是对角距离 (octile), 4 方向是曼哈顿距离
+  int geometric(int x, int y) const;
+  // 从地标 l 出发, 把 seeds 中的方格的距离向外传播 (只会变小)
+  // 返回修改的表项数
+  int propagate(int l, const std::vector<std::pair<int, int>> &seeds);
+  // 最大的连通块中的一个方格
+  int largestComponentCell(const std::vector<int> &free_cells);
+  // 选择地标并计算距离表
+  void build();
+};
+
+#endif
@@ -0,0 +1,42 @@
+#include "open_list.h"
+
+#include <algorithm>
+
+void OpenList::Reset(Kind kind) {
+  this->kind = kind;
+  while (heap.size()) heap.pop();
+  // 保留桶的内存, 下次复用
+  for (int p = cursor; count > 0; p++) {
+    count -= buckets[p & mask].size();
+    buckets[p & mask].clear();
+  }
+  cursor = last = 0;
+}
+
+void OpenList::growBuckets(int lo, int hi) {
+  size_t n = std::max<size_t>(buckets.size(), 64);
+  while (n <= static_cast<size_t>(hi - lo)) n *= 2;
+  std::vector<std::vector<int>> old(n);
+  old.swap(buckets);
+  int old_mask = mask;
+  mask = n - 1;
+  // 旧的元素的优先级都在 [cursor, last] 中, 按优先级搬到新的位置
+  for (int p = cursor; count > 0 && p <= last; p++)
+    buckets[p & mask].swap(old[p & old_mask]);
+}
+
+void OpenList::pushBucket(const P &p) {
+  auto [priority, x] = p;
+  // 队列是空的, 以这个优先级为起点, 所有桶都是空的, 可以直接复用
+  if (count == 0) cursor = last = priority;
+  int lo = std::min(cursor, priority), hi = std::max(last, priority);
+  if (static_cast<size_t>(hi - lo) >= buckets.size()) growBuckets(lo, hi);
+  buckets[priority & mask].push_back(x);
+  cursor = lo;
+  last = hi;
+  count++;
+}
+
+OpenList::Kind OpenListKindOf(const std::string &name) {
+  return name == "bucket" ? OpenList::Kind::Bucket : OpenList::Kind::Heap;
+}
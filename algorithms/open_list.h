@@ -0,0 +1,70 @@
+#ifndef PATH_FINDING_VISUALIZER_ALGORITHM_OPEN_LIST_H
+#define PATH_FINDING_VISUALIZER_ALGORITHM_OPEN_LIST_H
+
+#include <queue>
+#include <string>
+#include <vector>
+
+// 开放列表 (优先级队列), 元素是 {优先级, 节点}, 每次弹出优先级最小的.
+// 接口和 std::priority_queue 一致, 同一个节点可以重复入队 (lazy 删除).
+//
+// 有两种实现可选:
+//   heap: 二叉堆 (std::priority_queue), push 和 pop 都是 O(log n)
+//   bucket: 桶队列 (Dial), 每个整数优先级一个桶, push 是 O(1),
+//     pop 只需要向后移动游标找到第一个非空的桶.
+//     边权总是 COST_UNIT 或 DIAGONAL_COST, 优先级都是小整数.
+//     桶是循环数组, 优先级 p 放在 buckets[p & mask] 中,
+//     只要求队列中的优先级跨度小于桶的个数, 不够时按 2 倍扩容.
+//     非单调的优先级 (比如贪心) 也是 O(1) 的, 游标直接回退即可.
+//     同一个桶内是后进先出的, 所以相同优先级的节点的弹出顺序和 heap 不同.
+class OpenList {
+ public:
+  using P = std::pair<int, int>;
+  enum class Kind { Heap, Bucket };
+
+  // 清空, 并选用实现
+  void Reset(Kind kind);
+  void push(const P &p) {
+    if (kind == Kind::Heap) return heap.push(p);
+    pushBucket(p);
+  }
+  // 优先级最小的元素
+  P top() {
+    if (kind == Kind::Heap) return heap.top();
+    seekBucket();
+    return {cursor, buckets[cursor & mask].back()};
+  }
+  void pop() {
+    if (kind == Kind::Heap) return heap.pop();
+    seekBucket();
+    buckets[cursor & mask].pop_back();
+    count--;
+  }
+  bool empty() const { return size() == 0; }
+  size_t size() const { return kind == Kind::Heap ? heap.size() : count; }
+
+ private:
+  Kind kind = Kind::Heap;
+  std::priority_queue<P, std::vector<P>, std::greater<P>> heap;
+
+  // 循环数组, 个数是 2 的幂, buckets[p & mask] 是优先级为 p 的节点
+  std::vector<std::vector<int>> buckets;
+  int mask = -1;
+  // 游标是最小的优先级, 它之前的桶都是空的;
+  // last 是队列中优先级的上界, 队列清空前不会减小
+  int cursor = 0, last = 0;
+  size_t count = 0;
+
+  void pushBucket(const P &p);
+  // 扩容到能容纳 [lo, hi] 的优先级
+  void growBuckets(int lo, int hi);
+  // 把游标移动到第一个非空的桶
+  void seekBucket() {
+    while (buckets[cursor & mask].empty()) cursor++;
+  }
+};
+
+// 按名字选用开放列表的实现: "heap" 或者 "bucket"
+OpenList::Kind OpenListKindOf(const std::string &name);
+
+#endif
@@ -0,0 +1,128 @@
+#include "path_cache.h"
+
+#include <algorithm>
+
+PathCache PATH_CACHE;
+
+// 没有障碍物时 a 到 b 的最短路的代价, 是任何路径代价的下界
+static int lowerBound(const Point &a, const Point &b, bool use_4directions) {
+  int di = std::abs(a.first - b.first), dj = std::abs(a.second - b.second);
+  if (use_4directions) return (di + dj) * COST_UNIT;
+  return std::min(di, dj) * DIAGONAL_COST +
+         (std::max(di, dj) - std::min(di, dj)) * COST_UNIT;
+}
+
+bool PathCache::Get(const Key &key, std::vector<Point> &path) {
+  std::lock_guard<std::mutex> lock(mu);
+  if (capacity == 0) return false;
+  expire();
+  auto it = index.find(key);
+  if (it == index.end()) {
+    stats.misses++;
+    return false;
+  }
+  stats.hits++;
+  // 移到最前面
+  lru.splice(lru.begin(), lru, it->second);
+  path = it->second->path;
+  return true;
+}
+
+void PathCache::Put(const Key &key, const std::vector<Point> &path) {
+  std::lock_guard<std::mutex> lock(mu);
+  if (capacity == 0 || path.empty()) return;
+  expire();
+  if (auto it = index.find(key); it != index.end()) erase(it->second);
+  lru.push_front({key, path, PathCost(path), {}});
+  auto &e = lru.front();
+  for (const auto &p : path) e.regions.push_back(regionOf(p));
+  std::sort(e.regions.begin(), e.regions.end());
+  e.regions.erase(std::unique(e.regions.begin(), e.regions.end()),
+                  e.regions.end());
+  for (auto r : e.regions) by_region[r].insert(&e);
+  index[key] = lru.begin();
+  while (lru.size() > capacity) {
+    erase(std::prev(lru.end()));
+    stats.evictions++;
+  }
+}
+
+void PathCache::Invalidate(const std::vector<Point> &to_become_obstacles,
+                           const std::vector<Point> &to_remove_obstacles) {
+  std::lock_guard<std::mutex> lock(mu);
+  // 每个方格的修改 (GridMap::Set) 让地图版本加一,
+  // 版本对不上时说明还有未知的修改, 全部清空
+  uint64_t edits = to_become_obstacles.size() + to_remove_obstacles.size();
+  if (version + edits != GRID_MAP.Version()) return expire();
+  version = GRID_MAP.Version();
+  std::unordered_set<Entry *> victims;
+  for (const auto &p : to_become_obstacles) {
+    auto it = by_region.find(regionOf(p));
+    if (it != by_region.end())
+      victims.insert(it->second.begin(), it->second.end());
+  }
+  if (!to_remove_obstacles.empty()) {
+    for (auto &e : lru) {
+      for (const auto &c : to_remove_obstacles) {
+        bool d4 = e.key.use_4directions;
+        if (lowerBound(e.key.start, c, d4) + lowerBound(c, e.key.target, d4) <
+            e.cost) {
+          victims.insert(&e);
+          break;
+        }
+      }
+    }
+  }
+  for (auto *e : victims) erase(index[e->key]);
+  stats.invalidations += victims.size();
+}
+
+void PathCache::SetCapacity(size_t entries) {
+  std::lock_guard<std::mutex> lock(mu);
+  capacity = entries;
+  while (lru.size() > capacity) {
+    erase(std::prev(lru.end()));
+    stats.evictions++;
+  }
+}
+
+void PathCache::Clear() {
+  std::lock_guard<std::mutex> lock(mu);
+  lru.clear();
+  index.clear();
+  by_region.clear();
+}
+
+PathCache::Stats PathCache::GetStats() const {
+  std::lock_guard<std::mutex> lock(mu);
+  return stats;
+}
+
+size_t PathCache::Size() const {
+  std::lock_guard<std::mutex> lock(mu);
+  return lru.size();
+}
+
+void PathCache::expire() {
+  if (version == GRID_MAP.Version()) return;
+  version = GRID_MAP.Version();
+  stats.invalidations += lru.size();
+  lru.clear();
+  index.clear();
+  by_region.clear();
+}
+
+void PathCache::erase(std::list<Entry>::iterator it) {
+  for (auto r : it->regions) {
+    auto &entries = by_region[r];
+    entries.erase(&*it);
+    if (entries.empty()) by_region.erase(r);
+  }
+  index.erase(it->key);
+  lru.erase(it);
+}
+
+int PathCache::regionOf(const Point &p) const {
+  int cols = (GRID_MAP.Cols() + REGION - 1) / REGION;
+  return p.first / REGION * cols + p.second / REGION;
+}
@@ -0,0 +1,95 @@
+#ifndef PATH_FINDING_VISUALIZER_ALGORITHM_PATH_CACHE_H
+#define PATH_FINDING_VISUALIZER_ALGORITHM_PATH_CACHE_H
+
+#include <compare>
+#include <cstdint>
+#include <list>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "../base.h"
+
+// 进程内共享的寻路结果缓存, 按 (起点, 终点, 算法, 方向数) 索引.
+// 同一对方格的重复查询直接返回上次的路径, 不再搜索.
+// 其余的选项 (启发式, 权重等) 不在键中, 使用者要保证它们在进程内不变.
+//
+// 每条路径按它经过的 REGION x REGION 的区域建立索引, 地图修改后 (Invalidate):
+//   - 新增的障碍物只让经过它的路径失效, 淘汰经过它所在区域的路径;
+//   - 移除的障碍物可能让任何路径变得不再最短, 淘汰满足
+//     h(起点, c) + h(c, 终点) < 代价 的路径 (h 是几何距离, 是下界),
+//     其余的路径不可能经过 c 变短.
+// 所以对于求最短路的算法, 命中的路径仍然是最短路.
+// 条目数超过容量时, 淘汰最久没有使用的路径 (LRU). 线程安全.
+class PathCache {
+ public:
+  struct Key {
+    Point start, target;
+    std::string algorithm;
+    bool use_4directions;
+    auto operator<=>(const Key &) const = default;
+  };
+  struct Stats {
+    uint64_t hits = 0, misses = 0;
+    // 因为地图修改而淘汰的条目数
+    uint64_t invalidations = 0;
+    // 因为容量而淘汰的条目数
+    uint64_t evictions = 0;
+    double HitRate() const {
+      return hits + misses ? double(hits) / (hits + misses) : 0;
+    }
+  };
+
+  // 区域的边长
+  static constexpr int REGION = 16;
+
+  // 查找, 命中时写到 path 并返回 true
+  bool Get(const Key &key, std::vector<Point> &path);
+  // 放入 (或者替换) 一条完整的路径 (包含起点和终点)
+  void Put(const Key &key, const std::vector<Point> &path);
+  // GRID_MAP 用 Set 逐个修改了这些方格之后调用, 淘汰受影响的路径.
+  // 没有经过 Invalidate 的修改 (比如重新加载地图) 会让地图版本对不上,
+  // 此时 (以及下次 Get 和 Put 时) 清空全部条目
+  void Invalidate(const std::vector<Point> &to_become_obstacles,
+                  const std::vector<Point> &to_remove_obstacles);
+  // 设置容量 (条目数), 0 表示不缓存
+  void SetCapacity(size_t entries);
+  void Clear();
+
+  Stats GetStats() const;
+  size_t Size() const;
+
+ private:
+  struct Entry {
+    Key key;
+    std::vector<Point> path;
+    int cost;
+    // 路径经过的区域
+    std::vector<int> regions;
+  };
+
+  mutable std::mutex mu;
+  size_t capacity = 0;
+  // 缓存的路径对应的地图版本 (GRID_MAP.Version())
+  uint64_t version = 0;
+  Stats stats;
+  // 按最近使用排列, 最前面的是最近使用的
+  std::list<Entry> lru;
+  std::map<Key, std::list<Entry>::iterator> index;
+  // 区域 => 经过它的路径
+  std::unordered_map<int, std::unordered_set<Entry *>> by_region;
+
+  // 以下要求已经持有锁
+  // 地图版本变化时清空
+  void expire();
+  void erase(std::list<Entry>::iterator it);
+  int regionOf(const Point &p) const;
+};
+
+// 全局的寻路结果缓存
+extern PathCache PATH_CACHE;
+
+#endif
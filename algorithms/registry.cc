@@ -6,9 +6,14 @@
 #include "impl_astar.h"
 #include "impl_bidirectional_astar.h"
 #include "impl_bidirectional_dijkstra.h"
+#include "impl_cpd.h"
 #include "impl_dijkstra.h"
+#include "impl_dstar_lite.h"
 #include "impl_flow_field.h"
 #include "impl_greedy.h"
+#include "impl_hpastar.h"
+#include "impl_jps.h"
+#include "impl_jps_plus.h"
 #include "impl_lpastar.h"
 
 decltype(AlgorithmMakers) AlgorithmMakers = {
@@ -16,9 +21,15 @@ decltype(AlgorithmMakers) AlgorithmMakers = {
     {"greedy", []() { return std::make_unique<AlgorithmImplGreedy>(); }},
     {"astar", []() { return std::make_unique<AlgorithmImplAStar>(); }},
     {"lpastar", []() { return std::make_unique<AlgorithmImplLPAStar>(); }},
+    {"dstar-lite",
+     []() { return std::make_unique<AlgorithmImplDStarLite>(); }},
     {"dijkstra-bi",
      []() { return std::make_unique<AlgorithmImplBidirectionalDijkstra>(); }},
     {"astar-bi",
      []() { return std::make_unique<AlgorithmImplBidirectionalAStar>(); }},
     {"flow-field", []() { return std::make_unique<AlgorithmImplFlowField>(); }},
+    {"jps", []() { return std::make_unique<AlgorithmImplJPS>(); }},
+    {"jps-plus", []() { return std::make_unique<AlgorithmImplJPSPlus>(); }},
+    {"hpastar", []() { return std::make_unique<AlgorithmImplHPAStar>(); }},
+    {"cpd", []() { return std::make_unique<AlgorithmImplCPD>(); }},
 };
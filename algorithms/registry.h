@@ -2,6 +2,8 @@
 #define PATH_FINDING_VISUALIZER_ALGORITHM_REGISTRY_H
 
 #include <functional>
+#include <memory>
+#include <string>
 #include <unordered_map>
 
 #include "algorithm_base.h"
@@ -0,0 +1,57 @@
+#include "thread_pool.h"
+
+ThreadPool::ThreadPool(int threads) {
+  for (int k = 1; k < threads; k++)
+    workers.emplace_back(&ThreadPool::work, this, k);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(mu);
+    stopping = true;
+  }
+  cv.notify_all();
+  for (auto &worker : workers) worker.join();
+}
+
+void ThreadPool::ParallelFor(int n, const std::function<void(int, int)> &fn) {
+  if (workers.empty() || n <= 1) {
+    for (int i = 0; i < n; i++) fn(i, 0);
+    return;
+  }
+  {
+    std::lock_guard<std::mutex> lock(mu);
+    job = &fn;
+    job_size = n;
+    next = 0;
+    running = workers.size();
+    generation++;
+  }
+  cv.notify_all();
+  drain(0);
+  // 等待工作线程都放下这个任务, 之后 fn 才可以销毁
+  std::unique_lock<std::mutex> lock(mu);
+  cv.wait(lock, [&]() { return running == 0; });
+  job = nullptr;
+}
+
+void ThreadPool::drain(int thread) {
+  for (int i; (i = next++) < job_size;) (*job)(i, thread);
+}
+
+void ThreadPool::work(int thread) {
+  uint64_t seen = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mu);
+      cv.wait(lock, [&]() { return stopping || generation != seen; });
+      if (stopping) return;
+      seen = generation;
+    }
+    drain(thread);
+    {
+      std::lock_guard<std::mutex> lock(mu);
+      if (--running == 0) cv.notify_all();
+    }
+  }
+}
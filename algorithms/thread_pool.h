@@ -0,0 +1,47 @@
+#ifndef PATH_FINDING_VISUALIZER_ALGORITHM_THREAD_POOL_H
+#define PATH_FINDING_VISUALIZER_ALGORITHM_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 固定大小的线程池, 只支持一种用法: 把 n 个任务分给全部线程, 等待全部完成.
+// 调用者自己也算作一个线程, 所以 threads 个线程只需要 threads-1 个工作线程.
+// 线程常驻, 反复调用 ParallelFor 时不需要重新创建线程.
+class ThreadPool {
+ public:
+  explicit ThreadPool(int threads);
+  ~ThreadPool();
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // 线程数 (包括调用者)
+  int Threads() const { return workers.size() + 1; }
+  // 并行执行 fn(i, thread) , i 取 [0, n), 任务按下标动态分配.
+  // thread 是执行者的编号, 取 [0, Threads()), 可以用来索引每个线程的临时数据.
+  // 全部完成后返回. 同一时间只能有一个调用者
+  void ParallelFor(int n, const std::function<void(int, int)> &fn);
+
+ private:
+  std::vector<std::thread> workers;
+  std::mutex mu;
+  std::condition_variable cv;
+  // 当前的任务, 每次 ParallelFor 代数加一, 工作线程据此发现新的任务
+  const std::function<void(int, int)> *job = nullptr;
+  int job_size = 0;
+  uint64_t generation = 0;
+  std::atomic<int> next = 0;
+  // 还在执行当前任务的工作线程数
+  int running = 0;
+  bool stopping = false;
+
+  // 领取并执行任务, 直到没有剩余的下标
+  void drain(int thread);
+  void work(int thread);
+};
+
+#endif
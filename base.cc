@@ -6,8 +6,80 @@
 #include <fstream>
 #include <string>
 
-int GRID_MAP[M][N];
-bool CHANGED_GRIDS[M][N];
+#include "binary_map.h"
+#include "movingai.h"
+
+GridMap GRID_MAP;
+Grid<unsigned char> CHANGED_GRIDS;
+
+GridMap::~GridMap() {
+  if (release) release();
+}
+
+void GridMap::Resize(int m, int n) {
+  if (release) release();
+  release = nullptr;
+  tiles.reset();
+  masks.clear();
+  version++;
+  M = m, N = n;
+  storage.assign(static_cast<size_t>(m) * n, 0);
+  cells = storage.data();
+}
+
+void GridMap::Attach(int m, int n, unsigned char *data,
+                     std::function<void()> release) {
+  if (this->release) this->release();
+  this->release = std::move(release);
+  tiles.reset();
+  masks.clear();
+  version++;
+  M = m, N = n;
+  storage.clear();
+  storage.shrink_to_fit();
+  cells = data;
+}
+
+void GridMap::AttachTiles(int m, int n, std::unique_ptr<TileStore> tiles) {
+  if (release) release();
+  release = nullptr;
+  this->tiles = std::move(tiles);
+  masks.clear();
+  version++;
+  M = m, N = n;
+  storage.clear();
+  storage.shrink_to_fit();
+  cells = nullptr;
+}
+
+unsigned char GridMap::computeNeighborMask(int i, int j) const {
+  if (Get(i, j)) return 0;  // 不可从障碍物出发
+  unsigned char mask = 0;
+  for (int k = 0; k < 8; k++) {
+    const auto &[_, d] = DIRECTIONS[k];
+    int i1 = i + d.first, j1 = j + d.second;
+    // 不可到达障碍物, 不可越过边界
+    if (i1 >= 0 && i1 < M && j1 >= 0 && j1 < N && !Get(i1, j1))
+      mask |= 1 << k;
+  }
+  return mask;
+}
+
+void GridMap::PrepareNeighborMasks() {
+  if (tiles || !masks.empty()) return;
+  masks.resize(Size());
+  for (int i = 0, x = 0; i < M; i++)
+    for (int j = 0; j < N; j++, x++) masks[x] = computeNeighborMask(i, j);
+}
+
+void GridMap::patchNeighborMasks(int i, int j) {
+  masks[i * N + j] = computeNeighborMask(i, j);
+  for (const auto &[_, d] : DIRECTIONS) {
+    int i1 = i + d.first, j1 = j + d.second;
+    if (i1 >= 0 && i1 < M && j1 >= 0 && j1 < N)
+      masks[i1 * N + j1] = computeNeighborMask(i1, j1);
+  }
+}
 
 Point ParsePointString(const std::string &s) {
   std::string sx, sy;
@@ -23,48 +95,71 @@ Point ParsePointString(const std::string &s) {
   return {std::stoi(sx), std::stoi(sy)};
 }
 
-bool ValidatePoint(const Point &p) {
-  return p.first >= 0 && p.first < M && p.second >= 0 && p.second < N;
+bool ValidatePoint(const Point &p) { return ValidatePoint(p.first, p.second); }
+
+bool ValidatePoint(int x, int y) {
+  return x >= 0 && x < GRID_MAP.Rows() && y >= 0 && y < GRID_MAP.Cols();
 }
 
-bool ValidatePoint(int x, int y) { return x >= 0 && x < M && y >= 0 && y < N; }
+int PathCost(const std::vector<Point> &path) {
+  int cost = 0;
+  for (std::size_t k = 1; k < path.size(); k++) {
+    bool diagonal = path[k].first != path[k - 1].first &&
+                    path[k].second != path[k - 1].second;
+    cost += diagonal ? DIAGONAL_COST : COST_UNIT;
+  }
+  return cost;
+}
 
-int LoadMap(const std::string &filepath) {
-  std::fstream f;
-  f.open(filepath);
+int LoadMap(const std::string &filepath, int tile_budget) {
+  // 二进制格式的地图, 直接 mmap 或者分块加载
+  if (IsBinaryMapFile(filepath)) return LoadBinaryMap(filepath, tile_budget);
+  // MovingAI 格式的地图
+  if (IsMovingAIMapFile(filepath)) return LoadMovingAIMap(filepath);
+  std::ifstream f(filepath);
+  if (!f) {
+    spdlog::error("地图: 无法打开文件 {}", filepath);
+    return -1;
+  }
+  // 先读取全部行, 地图的行数 M 和列数 N 由文件内容决定
+  std::vector<std::string> lines;
   std::string line;
-  int x = 0;
   while (std::getline(f, line)) {
-    // 检查行数
-    if (x >= M) {
-      spdlog::error("地图: 必须恰好 {} 行", M);
-      f.close();
-      return -1;
-    }
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (!line.empty()) lines.push_back(line);
+  }
+  if (lines.empty()) {
+    spdlog::error("地图: 文件是空的");
+    return -1;
+  }
+  // 以第一行的字符个数决定列数 (算进去空格)
+  int m = lines.size(), n = (lines[0].size() + 1) / 2;
+  GRID_MAP.Resize(m, n);
+  for (int x = 0; x < m; x++) {
     // 检查每行字符个数
-    if (line.size() != N + N - 1) {  // 算进去空格
+    if (lines[x].size() != static_cast<size_t>(n + n - 1)) {  // 算进去空格
       spdlog::error(
           "地图: 每行必须是 {} 个 0 或者 1, 目前第 {} 行是 {} 个字符 "
           "(包含空格计算在内)",
-          N, x, line.size());
-      f.close();
+          n, x, lines[x].size());
       return -1;
     }
     // 读取每个字符
     int y = 0;
-    for (auto ch : line) {
+    for (auto ch : lines[x]) {
       if (ch == ' ') continue;
       int value = static_cast<int>(ch - '0');
       if (value != 0 && value != 1) {
         spdlog::error("地图: 每个字符要么是0要么是1, 发现了一个 '{}'", ch);
-        f.close();
         return -2;
       }
+      if (y >= n) {
+        spdlog::error("地图: 第 {} 行多于 {} 个 0 或者 1", x, n);
+        return -1;
+      }
       GRID_MAP[x][y++] = value;
     }
-    x++;
   }
-  f.close();
   return 0;
 }
 
@@ -79,11 +174,11 @@ int ValidateStartAndTarget(const Options &options) {
                   options.target.second);
     return -1;
   }
-  if (GRID_MAP[options.start.first][options.start.second]) {
+  if (GRID_MAP.Get(options.start.first, options.start.second)) {
     spdlog::error("start 选在了障碍物上");
     return -1;
   }
-  if (GRID_MAP[options.target.first][options.target.second]) {
+  if (GRID_MAP.Get(options.target.first, options.target.second)) {
     spdlog::error("target 选在了障碍物上");
     return -1;
   }
@@ -111,8 +206,9 @@ int ParseOptionsFromCommandline(int argc, char *argv[], Options &options) {
   program.add_argument("algorithm")
       .help("算法名称")
       .metavar("ALGORITHM")
-      .choices("dijkstra", "astar", "lpastar", "dijkstra-bi", "astar-bi",
-               "flow-field", "greedy")
+      .choices("dijkstra", "astar", "lpastar", "dstar-lite", "dijkstra-bi",
+               "astar-bi", "flow-field", "greedy", "jps", "jps-plus",
+               "hpastar", "cpd")
       .default_value(std::string("dijkstra"))
       .store_into(options.algorithm);
   program.add_argument("-d4", "--use-4-directions")
@@ -125,13 +221,50 @@ int ParseOptionsFromCommandline(int argc, char *argv[], Options &options) {
       .store_into(options.astar_heuristic_weight);
   program.add_argument("-astar-m", "--astar-heuristic-method")
       .help(
-          "AStar/LPAStar 算法的启发式方法, 曼哈顿 manhattan 或者 欧式距离 "
-          "euclidean; 对于4方向默认是曼哈顿, "
+          "AStar/LPAStar 算法的启发式方法, 曼哈顿 manhattan, 欧式距离 "
+          "euclidean 或者 地标 landmarks; 对于4方向默认是曼哈顿, "
           "8方向时默认是欧式")
       .default_value(std::string(""))
       .store_into(options.astar_heuristic_method);
+  program.add_argument("--landmarks")
+      .help("地标启发 (-astar-m landmarks) 的地标数量")
+      .default_value(8)
+      .store_into(options.landmark_count);
+  program.add_argument("--tile-budget")
+      .help("分块格式的地图最多常驻内存的分块数量")
+      .default_value(1024)
+      .store_into(options.tile_budget);
+  program.add_argument("--open-list")
+      .help("开放列表的实现, 二叉堆 heap 或者 桶队列 bucket")
+      .default_value(std::string("heap"))
+      .choices("heap", "bucket")
+      .store_into(options.open_list);
+  program.add_argument("--hpa-cluster-size")
+      .help("hpastar 的簇的边长")
+      .default_value(16)
+      .store_into(options.hpa_cluster_size);
+  program.add_argument("--cpd-file")
+      .help("cpd 的压缩路径数据库文件 (由 cpd-builder 生成), "
+            "不指定时只支持小地图, 在启动时构建")
+      .default_value(std::string(""))
+      .store_into(options.cpd_file);
+  program.add_argument("--flow-cache-mb")
+      .help("flow-field 的流场缓存的内存预算 (MB), 0 表示不缓存")
+      .default_value(256)
+      .store_into(options.flow_cache_mb);
+  program.add_argument("--flow-field-threads")
+      .help("flow-field 计算流场的线程数, 大于 1 时按分块并行地一次算完 "
+            "(不再逐步展示)")
+      .default_value(1)
+      .store_into(options.flow_field_threads);
+  program.add_argument("--headless")
+      .help("无界面模式, 不初始化 SDL, 执行算法到结束后输出路径, 代价和耗时")
+      .default_value(false)
+      .store_into(options.headless);
   program.add_argument("-s", "--start").help("起始点").default_value("0,0");
-  program.add_argument("-t", "--target").help("起始点").default_value("11,14");
+  program.add_argument("-t", "--target")
+      .help("终点, 默认是地图的右下角")
+      .default_value("");
 
   try {
     program.parse_args(argc, argv);
@@ -142,7 +275,8 @@ int ParseOptionsFromCommandline(int argc, char *argv[], Options &options) {
 
   // 起始点 和 终点
   options.start = ParsePointString(program.get<std::string>("--start"));
-  options.target = ParsePointString(program.get<std::string>("--target"));
+  auto target = program.get<std::string>("--target");
+  if (!target.empty()) options.target = ParsePointString(target);
 
   // 处理启发式函数的选用
   if (options.astar_heuristic_method.empty()) {
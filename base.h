@@ -1,28 +1,26 @@
 #ifndef PATH_FINDING_VISUALIZER_BASE_H
 #define PATH_FINDING_VISUALIZER_BASE_H
 
+#include <algorithm>
+#include <cassert>
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
+#include <type_traits>
 #include <vector>
 
+#include "tile_store.h"
+
 // 坐标 (i, j)
 using Point = std::pair<int, int>;
 
 // 全局设置
-const int GRID_SIZE = 40;                 // 绘制每个网格 Pixel 的个数
-const int M = 12;                         // 方格行数, 迭代变量 i
-const int N = 15;                         // 方格列数, 迭代变量 j
-const int WINDOW_HEIGHT = M * GRID_SIZE;  // 窗口高度 600
-const int WINDOW_WIDTH = N * GRID_SIZE;   // 窗口宽度 800
+const int GRID_SIZE = 40;  // 绘制每个网格 Pixel 的个数
 const int COST_UNIT = 10;  // 默认边长 10, 即代价单位, 水平和垂直方向代价
 const int DIAGONAL_COST = 14;  // 对角成本是 14 (根号2 x 10)
 const int inf = 0x3f3f3f3f;
 
-// 网格地图: 0 表示空白方格 (白色), 1 表示有障碍物 (灰色)
-extern int GRID_MAP[M][N];
-
-// 记录下被修改过的位置(只为渲染), 主要 for Visualizer
-extern bool CHANGED_GRIDS[M][N];
-
 // 方向 和 成本
 const std::pair<int, std::pair<int, int>> DIRECTIONS[8] = {
     // 前 4 个是水平和竖直
@@ -37,6 +35,267 @@ const std::pair<int, std::pair<int, int>> DIRECTIONS[8] = {
     {DIAGONAL_COST, {1, 1}},    // 右下
 };
 
+// 运行时尺寸的二维网格, 按行连续存储在堆上, 用 grid[i][j] 访问.
+// 行数 M 对应迭代变量 i, 列数 N 对应迭代变量 j.
+// 注意不要用 bool 作为元素类型 (std::vector<bool> 不是连续存储的)
+template <typename T>
+class Grid {
+  static_assert(!std::is_same_v<T, bool>, "use unsigned char instead of bool");
+
+ public:
+  // 重设尺寸, 并把全部方格填充为 value
+  // 尺寸不变时不会重新分配内存
+  void Resize(int m, int n, T value = T()) {
+    M = m, N = n;
+    data.assign(static_cast<size_t>(m) * n, value);
+  }
+  // 把全部方格填充为 value
+  void Fill(T value) { std::fill(data.begin(), data.end(), value); }
+  T *operator[](int i) { return data.data() + static_cast<size_t>(i) * N; }
+  const T *operator[](int i) const {
+    return data.data() + static_cast<size_t>(i) * N;
+  }
+  int Rows() const { return M; }
+  int Cols() const { return N; }
+
+ private:
+  int M = 0, N = 0;
+  std::vector<T> data;
+};
+
+// 带代数标记的数组, 用于每次寻路都要重置的搜索状态.
+// 每个元素带一个代数 (generation), 和当前代数不一致的元素视为默认值,
+// 所以 Reset 只需要把当前代数加一, 是 O(1) 的;
+// 一次寻路的开销只和实际访问到的元素数量有关, 而不是整个地图的大小.
+//
+// 分块存储的地图 (见 tile_store.h) 可能大到放不下整张地图的搜索状态,
+// 此时用 ResizePaged 分页存储: 页和地图的分块一一对应, 第一次访问时才分配,
+// Reset 时释放, 所以内存只和一次寻路访问到的分块数有关.
+template <typename T>
+class StampedArray {
+ public:
+  // 重设尺寸, 并把全部元素清空为 value
+  // 尺寸不变时不会重新分配内存, 是 O(1) 的
+  void Resize(int n, T value = T()) {
+    default_value = value;
+    if (!paged && n == size) return Reset();
+    releasePages();
+    pages.clear();
+    paged = false;
+    size = n;
+    entries.assign(n, {0, value});
+    generation = 1;
+  }
+  // 分页存储 m*n 的二维网格 (标号 i*n+j) 的元素, 每页是边长 1<<shift 的
+  // 正方形, 并把全部元素清空为 value. 尺寸不变时只释放已经分配的页
+  void ResizePaged(int m, int n, int shift, T value = T()) {
+    default_value = value;
+    if (paged && m * n == size && n == cols && shift == page_shift)
+      return Reset();
+    std::vector<Entry>().swap(entries);
+    releasePages();
+    paged = true;
+    size = m * n;
+    cols = n;
+    page_shift = shift;
+    pages_per_row = (n + (1 << shift) - 1) >> shift;
+    pages.clear();
+    pages.resize(static_cast<size_t>((m + (1 << shift) - 1) >> shift) *
+                 pages_per_row);
+    generation = 1;
+  }
+  // 把全部元素清空为默认值, O(1); 分页存储时释放全部的页
+  void Reset() {
+    releasePages();
+    if (++generation == 0) {
+      // 代数回绕, 才需要真正地清理一次
+      for (auto &e : entries) e.stamp = 0;
+      generation = 1;
+    }
+  }
+  // 访问元素, 代数过期的元素先清空为默认值
+  T &operator[](int x) {
+    auto &e = paged ? pageEntry(x) : entries[x];
+    if (e.stamp != generation) e = {generation, default_value};
+    return e.value;
+  }
+  T Get(int x) const {
+    const Entry *e = paged ? findPageEntry(x) : &entries[x];
+    return e != nullptr && e->stamp == generation ? e->value : default_value;
+  }
+  int Size() const { return size; }
+
+ private:
+  // 代数和值放在一起, 访问时只需要一次缓存读取
+  struct Entry {
+    uint32_t stamp;
+    T value;
+  };
+  std::vector<Entry> entries;
+  uint32_t generation = 1;
+  T default_value = T();
+  int size = 0;
+
+  // 分页存储: pages[页号] 没有分配时是 nullptr, 已经分配的页号记在 used_pages
+  bool paged = false;
+  int cols = 0, page_shift = 0, pages_per_row = 0;
+  std::vector<std::unique_ptr<Entry[]>> pages;
+  std::vector<int> used_pages;
+
+  int pageOf(int i, int j) const {
+    return (i >> page_shift) * pages_per_row + (j >> page_shift);
+  }
+  int offsetInPage(int i, int j) const {
+    int mask = (1 << page_shift) - 1;
+    return ((i & mask) << page_shift) + (j & mask);
+  }
+  Entry &pageEntry(int x) {
+    int i = x / cols, j = x % cols, id = pageOf(i, j);
+    if (pages[id] == nullptr) {
+      // 值初始化, 代数都是 0, 视为默认值
+      pages[id] = std::make_unique<Entry[]>(size_t(1) << (2 * page_shift));
+      used_pages.push_back(id);
+    }
+    return pages[id][offsetInPage(i, j)];
+  }
+  const Entry *findPageEntry(int x) const {
+    int i = x / cols, j = x % cols;
+    const auto &page = pages[pageOf(i, j)];
+    return page == nullptr ? nullptr : &page[offsetInPage(i, j)];
+  }
+  void releasePages() {
+    for (int id : used_pages) pages[id].reset();
+    used_pages.clear();
+  }
+};
+
+// 带代数标记的二维网格, 用 grid[i][j] 访问, 见 StampedArray
+template <typename T>
+class StampedGrid {
+ public:
+  class Row {
+   public:
+    Row(StampedArray<T> &data, int base) : data(data), base(base) {}
+    T &operator[](int j) { return data[base + j]; }
+
+   private:
+    StampedArray<T> &data;
+    int base;
+  };
+  class ConstRow {
+   public:
+    ConstRow(const StampedArray<T> &data, int base) : data(data), base(base) {}
+    T operator[](int j) const { return data.Get(base + j); }
+
+   private:
+    const StampedArray<T> &data;
+    int base;
+  };
+
+  // 重设尺寸, 并把全部方格清空为 value, 尺寸不变时是 O(1) 的
+  void Resize(int m, int n, T value = T()) {
+    M = m, N = n;
+    data.Resize(m * n, value);
+  }
+  // 按边长 1<<shift 的正方形分页存储, 见 StampedArray::ResizePaged
+  void ResizePaged(int m, int n, int shift, T value = T()) {
+    M = m, N = n;
+    data.ResizePaged(m, n, shift, value);
+  }
+  // 把全部方格清空为默认值, O(1)
+  void Reset() { data.Reset(); }
+  Row operator[](int i) { return {data, i * N}; }
+  ConstRow operator[](int i) const { return {data, i * N}; }
+  int Rows() const { return M; }
+  int Cols() const { return N; }
+
+ private:
+  int M = 0, N = 0;
+  StampedArray<T> data;
+};
+
+// 网格地图: 0 表示空白方格 (白色), 1 表示有障碍物 (灰色)
+// 尺寸由地图文件决定 (见 LoadMap)
+// 方格数据要么是自己持有的内存, 要么是外部的一块内存 (比如 mmap 的地图文件),
+// 要么是按需从磁盘加载的分块 (见 tile_store.h).
+// 分块存储时不能用 operator[] 按行访问, 只能用 Get 和 Set.
+class GridMap {
+ public:
+  GridMap() = default;
+  GridMap(const GridMap &) = delete;
+  GridMap &operator=(const GridMap &) = delete;
+  ~GridMap();
+  // 重设尺寸, 全部方格清空为 0
+  void Resize(int m, int n);
+  // 直接采用外部的一块 m*n 字节的内存作为方格数据, 不做拷贝
+  // release 会在这块内存不再被使用时调用
+  void Attach(int m, int n, unsigned char *data, std::function<void()> release);
+  // 采用分块存储, 方格按需从磁盘加载
+  void AttachTiles(int m, int n, std::unique_ptr<TileStore> tiles);
+  // 分块存储时返回 TileStore, 否则是 nullptr
+  TileStore *Tiles() const { return tiles.get(); }
+  unsigned char Get(int i, int j) const {
+    if (tiles) return tiles->Get(i, j);
+    return cells[static_cast<size_t>(i) * N + j];
+  }
+  // 注意修改方格要用 Set, 以便同时修正邻居位掩码
+  void Set(int i, int j, unsigned char value) {
+    version++;
+    if (tiles) return tiles->Set(i, j, value);
+    cells[static_cast<size_t>(i) * N + j] = value;
+    if (!masks.empty()) patchNeighborMasks(i, j);
+  }
+  // 地图的版本号, 每次修改方格或者重新加载地图时递增.
+  // 算法可以用它判断自己缓存的预处理数据是否过期.
+  uint64_t Version() const { return version; }
+  // 方格 x (标号 i*N+j) 的可通行邻居的方向位掩码:
+  // 第 k 位是 1 表示沿 DIRECTIONS[k] 可以走到一个可通行的邻居, 障碍物方格是 0.
+  // 非分块存储时由 PrepareNeighborMasks 整体计算一次, 之后 Set 时 O(1) 修正;
+  // 分块存储时按需从分块计算.
+  unsigned char NeighborMask(int x) const {
+    if (tiles) return computeNeighborMask(x / N, x % N);
+    return masks[x];
+  }
+  // 计算全部方格的邻居位掩码, 已经计算过时什么都不做
+  void PrepareNeighborMasks();
+  unsigned char *operator[](int i) {
+    assert(!tiles);
+    return cells + static_cast<size_t>(i) * N;
+  }
+  const unsigned char *operator[](int i) const {
+    assert(!tiles);
+    return cells + static_cast<size_t>(i) * N;
+  }
+  // 方格行数, 迭代变量 i
+  int Rows() const { return M; }
+  // 方格列数, 迭代变量 j
+  int Cols() const { return N; }
+  // 总的节点数量
+  int Size() const { return M * N; }
+
+ private:
+  int M = 0, N = 0;
+  uint64_t version = 0;
+  unsigned char *cells = nullptr;
+  // 自己持有的内存, Attach 时为空
+  std::vector<unsigned char> storage;
+  // 外部内存的释放函数
+  std::function<void()> release;
+  // 分块存储
+  std::unique_ptr<TileStore> tiles;
+  // 邻居位掩码, 按标号存储, 没有计算过时是空的
+  std::vector<unsigned char> masks;
+
+  unsigned char computeNeighborMask(int i, int j) const;
+  // 修正方格 (i,j) 及其邻居的位掩码
+  void patchNeighborMasks(int i, int j);
+};
+
+extern GridMap GRID_MAP;
+
+// 记录下被修改过的位置(只为渲染), 主要 for Visualizer
+extern Grid<unsigned char> CHANGED_GRIDS;
+
 // 字体 Arrow 中的字符
 const char DIRECTIONS_CHAR[9] = "ABCDEFGH";
 
@@ -54,14 +313,34 @@ struct Options {
   // 要演示的算法
   std::string algorithm = "dijkstra";
   // 起始点, 终点
-  Point start = {0, 0}, target = {M - 1, N - 1};
+  // 未指定终点时是 {-1, -1}, 加载地图后取地图的右下角
+  Point start = {0, 0}, target = {-1, -1};
   // 是否只采用 4 方向, 默认是 8 方向
   bool use_4directions = false;
-  // astar/lpastar 的启发式权重, 默认是 1 倍权重, 0 时退化到 dijkstra
+  // astar/lpastar/dstar-lite 的启发式权重, 默认是 1 倍权重, 0 时退化到 dijkstra
   int astar_heuristic_weight = 1;
   // astar 的启发式方法, 可选两种: 曼哈顿距离 'manhattan' 和 欧式距离
   // 'euclidean' 对于 4 方向, 默认是曼哈顿; 对于 8 方向默认是欧式
   std::string astar_heuristic_method = "";
+  // 地标启发 'landmarks' 的地标数量 (见 algorithms/landmarks.h)
+  int landmark_count = 8;
+  // 分块格式的地图, 最多常驻内存的分块数量
+  int tile_budget = 1024;
+  // 开放列表的实现: 二叉堆 'heap' 或者 桶队列 'bucket' (见 open_list.h)
+  std::string open_list = "heap";
+  // hpastar 的簇的边长
+  int hpa_cluster_size = 16;
+  // cpd 的压缩路径数据库文件, 为空时在启动时构建 (见 algorithms/cpd.h)
+  std::string cpd_file = "";
+  // 流场缓存的内存预算 (MB), 0 表示不缓存 (见 algorithms/flow_field_cache.h)
+  int flow_cache_mb = 256;
+  // flow-field 计算流场的线程数, 大于 1 时按分块并行地一次算完
+  int flow_field_threads = 1;
+  // 批量查询的寻路结果缓存的容量 (条目数), 0 表示不缓存
+  // (见 algorithms/path_cache.h)
+  int path_cache_entries = 0;
+  // 无界面模式: 不初始化 SDL, 直接执行算法到结束并输出结果
+  bool headless = false;
 };
 
 // 黑板, 算法实现者要把寻路中的数据写到这里, Visualizer
@@ -71,38 +350,61 @@ struct Blackboard {
   bool isStopped = false;
   // 历史考察过的点, 即 访问数组
   // 有的也叫做 closed_set
-  bool visited[M][N];
+  // 每次寻路时的清理是 O(1) 的 (见 StampedGrid)
+  StampedGrid<unsigned char> visited;
   // 当前候选的待扩展的点的代价值
   // 不在待扩展列表中的, 标记 -1
   // 有的也叫做 open_set
-  int exploring[M][N];
+  StampedGrid<int> exploring;
   // 从出发到目标的一条最短路径 (包含 start 和 target)
+  // 分层的算法 (hpastar) 和查表的算法 (cpd) 在结束之前会逐段填写,
+  // 此时是从起点出发的可行走的前缀
   std::vector<Point> path;
   // 是否支持 flow 流场展示?
   bool isSupportedFlowField = false;
   // 如果支持流场展示的话, 这里设置方向标号
   // 设置为 -1 表示没有流
-  int flows[M][N];
+  // 流场可能在多个寻路实例之间共享 (见 algorithms/flow_field_cache.h),
+  // 所以是只读的
+  std::shared_ptr<const Grid<signed char>> flows;
+  // 扩展过的节点个数 (查表的算法是走过的方格数)
+  long long expansions = 0;
+  // 从开放列表中弹出的过期元素的个数 (同一个点重复入队, 已经扩展过)
+  long long stale_pops = 0;
+  // 脏方格: 上次绘制之后, visited 或 exploring 被修改过的方格 (pack 后的标号).
+  // 只有 track_dirty 时 (可视化) 才记录, 由绘制的一方清空, 可能有重复.
+  // 算法修改了这两个数组中的方格后, 需要调用 MarkDirty
+  bool track_dirty = false;
+  std::vector<int> dirty;
+  // 整体的修改 (清理黑板, 生成流场等) 不逐个记录, 而是标记需要全部重绘
+  bool dirty_all = true;
+  void MarkDirty(int x) {
+    if (track_dirty) dirty.push_back(x);
+  }
 };
 
-// 加载地图, 成功则返回 0
-int LoadMap(const std::string &filepath);
+// 加载地图, 地图的行数和列数由文件决定, 成功则返回 0
+// 支持文本格式 (空格分隔的 0 和 1), 二进制格式 (见 binary_map.h)
+// 以及 MovingAI 的 .map 格式 (见 movingai.h)
+// tile_budget 是分块格式的地图最多常驻内存的分块数量
+int LoadMap(const std::string &filepath, int tile_budget = 1024);
 // 解析命令行参数, 成功返回 0
 int ParseOptionsFromCommandline(int argc, char *argv[], Options &options);
 
 // Util 函数
 
-// 一个编码规则 i*N+j => 标号, 注意, 因为我们这里 N 比 M 大, 所以采用 N
-inline int pack(int i, int j) { return i * N + j; }
-inline int pack(const Point &p) { return p.first * N + p.second; }
-inline int unpack_i(int x) { return x / N; }
-inline int unpack_j(int x) { return x % N; }
-
-static const int n = M * N;  // 总的节点数量
+// 一个编码规则 i*N+j => 标号, N 是地图的列数
+inline int pack(int i, int j) { return i * GRID_MAP.Cols() + j; }
+inline int pack(const Point &p) { return pack(p.first, p.second); }
+inline int unpack_i(int x) { return x / GRID_MAP.Cols(); }
+inline int unpack_j(int x) { return x % GRID_MAP.Cols(); }
 
 // 一个切割类似 "x,y" 的字符串到 Point 的 util 函数
 Point ParsePointString(const std::string &s);
 
+// 路径的代价, 按边权累加 (水平竖直 COST_UNIT, 对角 DIAGONAL_COST)
+int PathCost(const std::vector<Point> &path);
+
 // 检查点是否在地图中
 bool ValidatePoint(const Point &p);
 bool ValidatePoint(int x, int y);
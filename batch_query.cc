@@ -0,0 +1,108 @@
+#include "batch_query.h"
+
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+
+#include "algorithms/path_cache.h"
+#include "algorithms/registry.h"
+
+int BatchQueryRunner::Prepare(const Options &options, int threads) {
+  auto it = AlgorithmMakers.find(options.algorithm);
+  if (it == AlgorithmMakers.end()) {
+    spdlog::error("找不到算法实现:  {}", options.algorithm);
+    return -1;
+  }
+  threads = std::max(1, threads);
+  workers.clear();
+  workers.resize(threads);
+  for (auto &w : workers) {
+    w.algo = it->second();
+    w.options = options;
+  }
+  if (GRID_MAP.Tiles() && !workers[0].algo->SupportsTiledMap(options)) {
+    spdlog::error("算法 {} 不支持分块地图", options.algorithm);
+    workers.clear();
+    return -1;
+  }
+  pool = threads > 1 ? std::make_unique<ThreadPool>(threads) : nullptr;
+  map_version = 0;
+  if (options.path_cache_entries > 0)
+    PATH_CACHE.SetCapacity(options.path_cache_entries);
+  return 0;
+}
+
+int BatchQueryRunner::Run(const VersionedMap &versions,
+                          const std::vector<Query> &queries,
+                          std::vector<QueryResult> &results) {
+  auto snapshot = versions.Current();
+  if (snapshot == nullptr) return Run(queries, results);
+  if (snapshot->Version() != map_version) {
+    MapChanges changes;
+    if (versions.Sync(GRID_MAP, map_version, *snapshot, changes) != 0) {
+      results.assign(queries.size(), {});
+      return 0;
+    }
+    PATH_CACHE.Invalidate(changes.to_become_obstacles,
+                          changes.to_remove_obstacles);
+    map_version = snapshot->Version();
+  }
+  int ok = Run(queries, results);
+  for (auto &r : results) r.version = map_version;
+  return ok;
+}
+
+int BatchQueryRunner::Run(const std::vector<Query> &queries,
+                          std::vector<QueryResult> &results) {
+  results.assign(queries.size(), {});
+  if (workers.empty()) return 0;
+  // 邻居位掩码是按需计算的, 先算好, 之后各个线程对地图都是只读的
+  GRID_MAP.PrepareNeighborMasks();
+  if (pool == nullptr || GRID_MAP.Tiles()) {
+    for (std::size_t k = 0; k < queries.size(); k++)
+      runOne(workers[0], queries[k], results[k]);
+  } else {
+    pool->ParallelFor(queries.size(), [&](int k, int thread) {
+      runOne(workers[thread], queries[k], results[k]);
+      results[k].thread = thread;
+    });
+  }
+  int ok = 0;
+  for (const auto &r : results) ok += r.code == 0;
+  return ok;
+}
+
+void BatchQueryRunner::runOne(Worker &w, const Query &q, QueryResult &r) {
+  w.options.start = q.start;
+  w.options.target = q.target;
+  if (ValidateStartAndTarget(w.options) != 0) return;
+  auto t0 = std::chrono::steady_clock::now();
+  PathCache::Key key{q.start, q.target, w.options.algorithm,
+                     w.options.use_4directions};
+  bool use_cache = w.options.path_cache_entries > 0;
+  if (use_cache && PATH_CACHE.Get(key, r.path)) {
+    r.code = 0;
+    r.cost = PathCost(r.path);
+    r.cached = true;
+    r.search_us = std::chrono::duration<double, std::micro>(
+                      std::chrono::steady_clock::now() - t0)
+                      .count();
+    return;
+  }
+  w.algo->Setup(w.b, w.options);
+  auto t1 = std::chrono::steady_clock::now();
+  // 不限预算, 一次执行到结束
+  StepUsage used;
+  int code = w.algo->Step(w.b, {}, used);
+  auto t2 = std::chrono::steady_clock::now();
+  r.code = code == 0 ? 0 : -2;
+  r.expansions = w.b.expansions;
+  r.stale_pops = w.b.stale_pops;
+  r.setup_us = std::chrono::duration<double, std::micro>(t1 - t0).count();
+  r.search_us = std::chrono::duration<double, std::micro>(t2 - t1).count();
+  if (r.code == 0) {
+    r.path = w.b.path;
+    r.cost = PathCost(r.path);
+    if (use_cache) PATH_CACHE.Put(key, r.path);
+  }
+}
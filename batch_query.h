@@ -0,0 +1,73 @@
+#ifndef PATH_FINDING_VISUALIZER_BATCH_QUERY_H
+#define PATH_FINDING_VISUALIZER_BATCH_QUERY_H
+
+#include <memory>
+#include <vector>
+
+#include "algorithms/algorithm_base.h"
+#include "algorithms/thread_pool.h"
+#include "base.h"
+#include "map_snapshot.h"
+
+// 批量查询: 把一批互不相关的 (起点, 终点) 查询分给多个线程执行.
+// 每个线程有自己的算法实例 (由 AlgorithmMakers 创建) 和黑板,
+// 在多次查询之间复用, 所以各个算法缓存的预处理数据 (地标, 簇, 数据库等)
+// 和按代数清理的搜索状态都只在第一次查询时分配 (预处理是每个线程各做一次的).
+// 各个线程共享的只有只读的 GRID_MAP, 执行期间不能修改地图.
+// 分块存储的地图 (分块的缓存不是线程安全的) 只用调用者一个线程执行.
+// options.path_cache_entries 大于 0 时, 重复的查询直接取自 PATH_CACHE
+// (见 algorithms/path_cache.h), 固定新的地图版本时淘汰受影响的路径.
+
+struct Query {
+  Point start, target;
+};
+
+struct QueryResult {
+  // 0 成功, -2 寻路失败或者起点终点不合法
+  int code = -2;
+  // 最短路径 (包含 start 和 target) 和它的代价
+  std::vector<Point> path;
+  int cost = 0;
+  // 扩展的节点数和过期弹出数 (见 Blackboard)
+  long long expansions = 0;
+  long long stale_pops = 0;
+  double setup_us = 0, search_us = 0;
+  // 执行这个查询的线程编号
+  int thread = 0;
+  // 执行时固定的地图快照版本 (见 map_snapshot.h), 没有固定版本时是 0
+  uint64_t version = 0;
+  // 是否直接取自寻路结果缓存 (此时没有扩展节点)
+  bool cached = false;
+};
+
+class BatchQueryRunner {
+ public:
+  // 按 options 中的算法和选项, 准备 threads 个线程 (包括调用者)
+  // 找不到算法时返回 -1, 成功返回 0. 可以重复调用, 换成新的选项
+  int Prepare(const Options &options, int threads);
+  // 执行全部查询, results 和 queries 按下标一一对应.
+  // 返回成功的查询数量
+  int Run(const std::vector<Query> &queries, std::vector<QueryResult> &results);
+  // 固定 versions 的当前版本执行全部查询: 先把 GRID_MAP 推进到这个版本,
+  // 执行期间其他线程可以继续发布新版本, 不影响这一批查询.
+  // 此时 GRID_MAP 只能由这个 runner 修改
+  int Run(const VersionedMap &versions, const std::vector<Query> &queries,
+          std::vector<QueryResult> &results);
+  int Threads() const { return workers.size(); }
+
+ private:
+  struct Worker {
+    std::unique_ptr<Algorithm> algo;
+    Blackboard b;
+    // 每个线程自己的选项, 只有起点和终点不同
+    Options options;
+  };
+  std::vector<Worker> workers;
+  std::unique_ptr<ThreadPool> pool;
+  // GRID_MAP 当前对应的快照版本, 0 表示未知
+  uint64_t map_version = 0;
+
+  void runOne(Worker &w, const Query &q, QueryResult &r);
+};
+
+#endif
@@ -0,0 +1,192 @@
+#include "binary_map.h"
+
+#include <fcntl.h>
+#include <spdlog/spdlog.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <climits>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+// 每行 bit 编码占用的字节数
+static size_t bitRowBytes(uint32_t cols) { return (cols + 7) / 8; }
+
+bool IsBinaryMapFile(const std::string &filepath) {
+  std::ifstream f(filepath, std::ios::binary);
+  char magic[4];
+  if (!f.read(magic, sizeof magic)) return false;
+  return memcmp(magic, BINARY_MAP_MAGIC, sizeof magic) == 0;
+}
+
+int LoadBinaryMap(const std::string &filepath, int tile_budget) {
+  int fd = open(filepath.c_str(), O_RDONLY);
+  if (fd < 0) {
+    spdlog::error("地图: 无法打开文件 {}", filepath);
+    return -1;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 ||
+      static_cast<size_t>(st.st_size) < sizeof(BinaryMapHeader)) {
+    spdlog::error("地图: 二进制地图文件太小 {}", filepath);
+    close(fd);
+    return -1;
+  }
+  size_t size = st.st_size;
+
+  BinaryMapHeader header;
+  if (pread(fd, &header, sizeof header, 0) != sizeof header ||
+      memcmp(header.magic, BINARY_MAP_MAGIC, sizeof header.magic) != 0 ||
+      header.version != BINARY_MAP_VERSION) {
+    spdlog::error("地图: 不支持的二进制地图格式或版本 {}", header.version);
+    close(fd);
+    return -2;
+  }
+  // 方格的标号 i*N+j 是 int, 总数不能超过 INT_MAX
+  if (header.rows == 0 || header.cols == 0 ||
+      static_cast<uint64_t>(header.rows) * header.cols > INT_MAX) {
+    spdlog::error("地图: 不合法的地图尺寸 {}x{}", header.rows, header.cols);
+    close(fd);
+    return -2;
+  }
+  if (header.offset < sizeof header || header.offset > size) {
+    spdlog::error("地图: 不合法的方格数据偏移 {}", header.offset);
+    close(fd);
+    return -2;
+  }
+  int m = header.rows, n = header.cols;
+
+  if (header.encoding == BINARY_MAP_ENCODING_TILED) {
+    // 边长有上限, 以免计算文件大小时溢出
+    if (header.tile_size == 0 || header.tile_size > MAX_TILE_SIZE ||
+        (header.tile_size & (header.tile_size - 1)) != 0) {
+      spdlog::error("地图: 分块边长必须是不超过 {} 的 2 的幂, 目前是 {}",
+                    MAX_TILE_SIZE, header.tile_size);
+      close(fd);
+      return -2;
+    }
+    int tile_size = header.tile_size;
+    size_t tiles = ((static_cast<size_t>(m) + tile_size - 1) / tile_size) *
+                   ((static_cast<size_t>(n) + tile_size - 1) / tile_size);
+    if (header.offset + tiles * tile_size * tile_size > size) {
+      spdlog::error("地图: 二进制地图文件不完整 {}", filepath);
+      close(fd);
+      return -2;
+    }
+    // 不读入任何方格, fd 交给 TileStore 持有
+    GRID_MAP.AttachTiles(m, n,
+                         std::make_unique<TileStore>(fd, header.offset, m, n,
+                                                     tile_size, tile_budget));
+    spdlog::info("地图: 分块加载, 分块边长 {}, 最多常驻 {} 个分块", tile_size,
+                 tile_budget);
+    return 0;
+  }
+
+  // 私有映射: 可以修改方格 (比如 Visualizer 翻转障碍物),
+  // 修改只发生在本进程的页面副本上, 不会写回文件
+  void *addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);  // 映射建立后即可关闭文件
+  if (addr == MAP_FAILED) {
+    spdlog::error("地图: mmap 失败 {}", filepath);
+    return -1;
+  }
+  auto release = [addr, size]() { munmap(addr, size); };
+  auto *data = static_cast<unsigned char *>(addr) + header.offset;
+
+  if (header.encoding == BINARY_MAP_ENCODING_BYTE) {
+    if (header.offset + static_cast<size_t>(m) * n > size) {
+      spdlog::error("地图: 二进制地图文件不完整 {}", filepath);
+      release();
+      return -2;
+    }
+    // 直接采用映射的内存, 无需拷贝
+    GRID_MAP.Attach(m, n, data, release);
+    return 0;
+  }
+
+  if (header.encoding == BINARY_MAP_ENCODING_BIT) {
+    size_t row_bytes = bitRowBytes(n);
+    if (header.offset + row_bytes * m > size) {
+      spdlog::error("地图: 二进制地图文件不完整 {}", filepath);
+      release();
+      return -2;
+    }
+    // bit 编码需要解码到 GRID_MAP 自己的内存中
+    GRID_MAP.Resize(m, n);
+    for (int i = 0; i < m; i++) {
+      const unsigned char *row = data + row_bytes * i;
+      for (int j = 0; j < n; j++) GRID_MAP[i][j] = (row[j >> 3] >> (j & 7)) & 1;
+    }
+    release();
+    return 0;
+  }
+
+  spdlog::error("地图: 未知的方格编码 {}", header.encoding);
+  release();
+  return -2;
+}
+
+int SaveBinaryMap(const std::string &filepath, const GridMap &grid_map,
+                  uint32_t encoding, int tile_size) {
+  BinaryMapHeader header{};
+  memcpy(header.magic, BINARY_MAP_MAGIC, sizeof header.magic);
+  header.version = BINARY_MAP_VERSION;
+  header.rows = grid_map.Rows();
+  header.cols = grid_map.Cols();
+  header.encoding = encoding;
+  header.offset = sizeof header;
+  if (encoding == BINARY_MAP_ENCODING_TILED) {
+    if (tile_size <= 0 || tile_size > static_cast<int>(MAX_TILE_SIZE) ||
+        (tile_size & (tile_size - 1)) != 0) {
+      spdlog::error("地图: 分块边长必须是不超过 {} 的 2 的幂, 目前是 {}",
+                    MAX_TILE_SIZE, tile_size);
+      return -1;
+    }
+    header.tile_size = tile_size;
+  }
+
+  std::ofstream f(filepath, std::ios::binary | std::ios::trunc);
+  if (!f) {
+    spdlog::error("地图: 无法写入文件 {}", filepath);
+    return -1;
+  }
+  f.write(reinterpret_cast<const char *>(&header), sizeof header);
+
+  int m = grid_map.Rows(), n = grid_map.Cols();
+  if (encoding == BINARY_MAP_ENCODING_BYTE) {
+    std::vector<unsigned char> row(n);
+    for (int i = 0; i < m; i++) {
+      for (int j = 0; j < n; j++) row[j] = grid_map.Get(i, j);
+      f.write(reinterpret_cast<const char *>(row.data()), row.size());
+    }
+  } else if (encoding == BINARY_MAP_ENCODING_BIT) {
+    std::vector<unsigned char> row(bitRowBytes(n));
+    for (int i = 0; i < m; i++) {
+      std::fill(row.begin(), row.end(), 0);
+      for (int j = 0; j < n; j++)
+        if (grid_map.Get(i, j)) row[j >> 3] |= 1 << (j & 7);
+      f.write(reinterpret_cast<const char *>(row.data()), row.size());
+    }
+  } else {
+    // 分块按行优先依次写入, 越过地图边缘的部分填充为障碍物
+    std::vector<unsigned char> tile(static_cast<size_t>(tile_size) * tile_size);
+    for (int ti = 0; ti < m; ti += tile_size) {
+      for (int tj = 0; tj < n; tj += tile_size) {
+        for (int i = 0; i < tile_size; i++)
+          for (int j = 0; j < tile_size; j++)
+            tile[i * tile_size + j] = (ti + i < m && tj + j < n)
+                                          ? grid_map.Get(ti + i, tj + j)
+                                          : 1;
+        f.write(reinterpret_cast<const char *>(tile.data()), tile.size());
+      }
+    }
+  }
+  if (!f) {
+    spdlog::error("地图: 写入文件失败 {}", filepath);
+    return -1;
+  }
+  return 0;
+}
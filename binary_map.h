@@ -0,0 +1,60 @@
+#ifndef PATH_FINDING_VISUALIZER_BINARY_MAP_H
+#define PATH_FINDING_VISUALIZER_BINARY_MAP_H
+
+#include <cstdint>
+#include <string>
+
+#include "base.h"
+
+// 二进制地图格式 (小端):
+//
+//   | 头部 BinaryMapHeader (32 字节) | 方格数据 |
+//
+// 方格数据按行存储, 有两种编码:
+//   0: 每个方格一个字节 (0 表示空白, 非 0 都表示障碍物), 加载时直接 mmap,
+//      不做任何拷贝, 启动是 O(1) 的, 且多个进程可以共享同一份页面.
+//   1: 每个方格一个 bit (每行按字节对齐, 低位在前), 文件小 8 倍,
+//      加载时需要解码一遍.
+//   2: 分块存储, 分块按行优先依次存储, 每个分块内是 tile_size*tile_size
+//      个字节 (越过地图边缘的部分填充为障碍物). 加载时不读入任何方格,
+//      而是在访问时按需读入分块 (见 tile_store.h), 用于超过内存的大地图.
+//
+// 加载时检查头部和文件大小: 尺寸为 0, 方格总数超过 INT_MAX,
+// 或者文件比头部声明的方格数据短, 都拒绝加载.
+
+// 文件头的魔数
+const char BINARY_MAP_MAGIC[4] = {'P', 'F', 'V', 'M'};
+// 当前的格式版本
+const uint32_t BINARY_MAP_VERSION = 1;
+// 方格数据的编码
+const uint32_t BINARY_MAP_ENCODING_BYTE = 0;
+const uint32_t BINARY_MAP_ENCODING_BIT = 1;
+const uint32_t BINARY_MAP_ENCODING_TILED = 2;
+// 分块边长的上限
+const uint32_t MAX_TILE_SIZE = 4096;
+
+struct BinaryMapHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t rows;      // 行数 M
+  uint32_t cols;      // 列数 N
+  uint32_t encoding;  // 方格数据的编码
+  uint32_t offset;    // 方格数据在文件中的偏移 (字节)
+  uint32_t tile_size;  // 分块边长, 只用于分块编码
+  uint32_t reserved;
+};
+
+static_assert(sizeof(BinaryMapHeader) == 32);
+
+// 文件是否是二进制格式的地图 (检查魔数)
+bool IsBinaryMapFile(const std::string &filepath);
+// 加载二进制格式的地图到 GRID_MAP, 成功返回 0
+// tile_budget 是分块编码时最多常驻内存的分块数量
+int LoadBinaryMap(const std::string &filepath, int tile_budget = 1024);
+// 保存地图到二进制格式的文件, 成功返回 0
+// tile_size 只用于分块编码, 必须是 2 的幂
+int SaveBinaryMap(const std::string &filepath, const GridMap &grid_map,
+                  uint32_t encoding = BINARY_MAP_ENCODING_BYTE,
+                  int tile_size = 64);
+
+#endif
@@ -0,0 +1,48 @@
+#include "headless.h"
+
+#include <spdlog/spdlog.h>
+
+#include <chrono>
+#include <string>
+
+int RunHeadless(const Options &options, Algorithm *algo) {
+  Blackboard b;
+  auto t0 = std::chrono::steady_clock::now();
+  algo->Setup(b, options);
+  auto t1 = std::chrono::steady_clock::now();
+  // 每次 Update 扩展一个节点, 直到结束
+  // 有的算法在结束前就给出路径的前缀 (见 Blackboard::path), 记录它的耗时
+  int code;
+  double first_path_us = -1;
+  while ((code = algo->Update(b)) == -1) {
+    if (first_path_us < 0 && !b.path.empty())
+      first_path_us = std::chrono::duration<double, std::micro>(
+                          std::chrono::steady_clock::now() - t1)
+                          .count();
+  }
+  auto t2 = std::chrono::steady_clock::now();
+
+  auto setup_us = std::chrono::duration<double, std::micro>(t1 - t0).count();
+  auto search_us = std::chrono::duration<double, std::micro>(t2 - t1).count();
+  spdlog::info("扩展节点数: {}, 过期弹出数: {}", b.expansions, b.stale_pops);
+  spdlog::info("耗时: Setup {:.1f}us, 寻路 {:.1f}us", setup_us, search_us);
+  if (first_path_us >= 0)
+    spdlog::info("路径前缀在寻路 {:.1f}us 后已经可用", first_path_us);
+  if (auto *tiles = GRID_MAP.Tiles()) {
+    const auto &stats = tiles->GetStats();
+    spdlog::info("分块地图: 命中 {}, 缺失 {}, 淘汰 {}, 常驻 {} 个分块",
+                 stats.hits, stats.misses, stats.evictions, tiles->Resident());
+  }
+  if (code != 0) {
+    spdlog::info("寻路失败");
+    return -2;
+  }
+  spdlog::info("代价: {}", PathCost(b.path));
+  std::string path;
+  for (const auto &[i, j] : b.path) {
+    if (!path.empty()) path += " ";
+    path += std::to_string(i) + "," + std::to_string(j);
+  }
+  spdlog::info("路径 ({} 个点): {}", b.path.size(), path);
+  return 0;
+}
@@ -0,0 +1,12 @@
+#ifndef PATH_FINDING_VISUALIZER_HEADLESS_H
+#define PATH_FINDING_VISUALIZER_HEADLESS_H
+
+#include "algorithms/algorithm_base.h"
+#include "base.h"
+
+// 无界面模式: 不依赖 SDL, 直接执行算法直到结束 (Update 返回 0 或 -2),
+// 然后输出路径, 代价, 耗时和扩展的节点数.
+// 成功返回 0, 寻路失败返回 -2
+int RunHeadless(const Options &options, Algorithm *algo);
+
+#endif
@@ -4,7 +4,10 @@
 
 #include "algorithms/registry.h"
 #include "base.h"
+#include "headless.h"
+#ifdef WITH_VISUALIZER
 #include "visualizer.h"
+#endif
 
 int main(int argc, char *argv[]) {
   // 解析命令行参数到给定的 options 结构.
@@ -12,8 +15,13 @@ int main(int argc, char *argv[]) {
   if (ParseOptionsFromCommandline(argc, argv, options) != 0) std::exit(1);
 
   // 加载地图
-  if (LoadMap(options.map_file_path) != 0) return -1;
-  spdlog::info("地图加载成功 ({})", options.map_file_path);
+  if (LoadMap(options.map_file_path, options.tile_budget) != 0) return -1;
+  spdlog::info("地图加载成功 ({}, {}x{})", options.map_file_path,
+               GRID_MAP.Rows(), GRID_MAP.Cols());
+
+  // 未指定终点时, 默认取地图的右下角
+  if (options.target == Point{-1, -1})
+    options.target = {GRID_MAP.Rows() - 1, GRID_MAP.Cols() - 1};
 
   // 结合地图检查下 起始点 和 终点
   if (ValidateStartAndTarget(options) != 0) return -1;
@@ -29,6 +37,22 @@ int main(int argc, char *argv[]) {
   auto algo = AlgorithmMakers[options.algorithm]();
   spdlog::info("选用了算法 {}", options.algorithm);
 
+  // 分块地图只支持不遍历整张地图的算法, 可视化也要绘制整张地图
+  if (GRID_MAP.Tiles()) {
+    if (!algo->SupportsTiledMap(options)) {
+      spdlog::error("算法 {} 不支持分块地图", options.algorithm);
+      return -1;
+    }
+    if (!options.headless) {
+      spdlog::error("分块地图不支持可视化, 请使用 --headless");
+      return -1;
+    }
+  }
+
+  // 无界面模式, 不涉及 SDL
+  if (options.headless) return RunHeadless(options, algo.get());
+
+#ifdef WITH_VISUALIZER
   // 构造 Visualizer
   Blackboard b;
   Visualizer visualizer(options, b, algo.get());
@@ -38,4 +62,8 @@ int main(int argc, char *argv[]) {
   visualizer.Start();
   visualizer.Destroy();
   return 0;
+#else
+  spdlog::error("构建时没有启用 SDL 可视化 (WITH_VISUALIZER), 请使用 --headless");
+  return -1;
+#endif
 }
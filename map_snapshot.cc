@@ -0,0 +1,145 @@
+#include "map_snapshot.h"
+
+#include <spdlog/spdlog.h>
+
+#include <map>
+#include <unordered_map>
+
+VersionedMap MAP_VERSIONS;
+
+int MapSnapshot::SharedTiles(const MapSnapshot &other) const {
+  if (tiles.size() != other.tiles.size()) return 0;
+  int shared = 0;
+  for (std::size_t k = 0; k < tiles.size(); k++)
+    shared += tiles[k] == other.tiles[k];
+  return shared;
+}
+
+int VersionedMap::Reset(const GridMap &map) {
+  if (map.Tiles()) {
+    spdlog::error("地图快照不支持分块存储的地图");
+    return -1;
+  }
+  const int TILE = MapSnapshot::TILE;
+  auto snapshot = std::make_shared<MapSnapshot>();
+  snapshot->M = map.Rows();
+  snapshot->N = map.Cols();
+  snapshot->tile_cols = (map.Cols() + TILE - 1) / TILE;
+  int tile_rows = (map.Rows() + TILE - 1) / TILE;
+  for (int r = 0; r < tile_rows; r++) {
+    for (int c = 0; c < snapshot->tile_cols; c++) {
+      auto tile = std::make_shared<MapSnapshot::Tile>(TILE * TILE, 0);
+      int i1 = std::min(map.Rows(), (r + 1) * TILE);
+      int j1 = std::min(map.Cols(), (c + 1) * TILE);
+      for (int i = r * TILE; i < i1; i++)
+        for (int j = c * TILE; j < j1; j++)
+          (*tile)[i % TILE * TILE + j % TILE] = map.Get(i, j) != 0;
+      snapshot->tiles.push_back(std::move(tile));
+    }
+  }
+  std::lock_guard<std::mutex> lock(mu);
+  snapshot->version = ++last_version;
+  log.clear();
+  current.store(std::move(snapshot));
+  return 0;
+}
+
+uint64_t VersionedMap::Publish(const MapChanges &changes) {
+  std::lock_guard<std::mutex> lock(mu);
+  auto base = current.load();
+  if (base == nullptr) return 0;
+  const int TILE = MapSnapshot::TILE;
+  // 分块的指针表是浅复制的, 下面只替换被修改的分块
+  auto next = std::make_shared<MapSnapshot>(*base);
+  // 本次已经复制过的分块 => 可以修改的副本
+  std::unordered_map<int, MapSnapshot::Tile *> copied;
+  MapChanges applied;
+  auto write = [&](const Point &p, unsigned char value,
+                   std::vector<Point> &out) {
+    const auto &[i, j] = p;
+    if (i < 0 || i >= next->M || j < 0 || j >= next->N) return;
+    if (next->Get(i, j) == value) return;
+    int k = i / TILE * next->tile_cols + j / TILE;
+    auto it = copied.find(k);
+    if (it == copied.end()) {
+      auto tile = std::make_shared<MapSnapshot::Tile>(*next->tiles[k]);
+      it = copied.emplace(k, tile.get()).first;
+      next->tiles[k] = std::move(tile);
+    }
+    (*it->second)[i % TILE * TILE + j % TILE] = value;
+    out.push_back(p);
+  };
+  for (const auto &p : changes.to_become_obstacles)
+    write(p, 1, applied.to_become_obstacles);
+  for (const auto &p : changes.to_remove_obstacles)
+    write(p, 0, applied.to_remove_obstacles);
+  if (applied.Empty()) return base->version;
+
+  next->version = ++last_version;
+  log.emplace_back(next->version, std::move(applied));
+  while (log.size() > log_limit) log.pop_front();
+  current.store(next);
+  return next->version;
+}
+
+int VersionedMap::ChangesBetween(uint64_t from, uint64_t to,
+                                 MapChanges &changes) const {
+  changes = {};
+  if (from == to) return 0;
+  std::lock_guard<std::mutex> lock(mu);
+  // 需要日志中有 from+1 到 to 的每一个版本 (Reset 会清空日志)
+  if (from > to || log.empty() || log.front().first > from + 1 ||
+      log.back().first < to)
+    return -1;
+  // 每个方格: {修改的次数, 最后的值}. 日志中的每次修改都改变了值,
+  // 所以修改奇数次的方格才有变化. 按坐标排序, 结果是确定的
+  std::map<Point, std::pair<int, unsigned char>> cells;
+  for (const auto &[version, c] : log) {
+    if (version <= from || version > to) continue;
+    for (const auto &p : c.to_become_obstacles) {
+      auto &[count, value] = cells[p];
+      count++, value = 1;
+    }
+    for (const auto &p : c.to_remove_obstacles) {
+      auto &[count, value] = cells[p];
+      count++, value = 0;
+    }
+  }
+  for (const auto &[p, cell] : cells) {
+    if (cell.first % 2 == 0) continue;
+    (cell.second ? changes.to_become_obstacles : changes.to_remove_obstacles)
+        .push_back(p);
+  }
+  return 0;
+}
+
+int VersionedMap::Sync(GridMap &map, uint64_t from, const MapSnapshot &to,
+                       MapChanges &changes) const {
+  if (map.Rows() != to.Rows() || map.Cols() != to.Cols()) {
+    spdlog::error("地图快照的尺寸 {}x{} 和地图 {}x{} 不同", to.Rows(),
+                  to.Cols(), map.Rows(), map.Cols());
+    return -1;
+  }
+  if (ChangesBetween(from, to.Version(), changes) != 0) {
+    // 日志不够, 逐个方格比较
+    changes = {};
+    for (int i = 0; i < to.Rows(); i++) {
+      for (int j = 0; j < to.Cols(); j++) {
+        // 地图中非 0 的方格都是障碍物 (见 binary_map.h), 快照中只有 0 和 1
+        if (!map.Get(i, j) == !to.Get(i, j)) continue;
+        (to.Get(i, j) ? changes.to_become_obstacles
+                      : changes.to_remove_obstacles)
+            .push_back({i, j});
+      }
+    }
+  }
+  for (const auto &[i, j] : changes.to_become_obstacles) map.Set(i, j, 1);
+  for (const auto &[i, j] : changes.to_remove_obstacles) map.Set(i, j, 0);
+  return 0;
+}
+
+void VersionedMap::SetLogLimit(size_t versions) {
+  std::lock_guard<std::mutex> lock(mu);
+  log_limit = std::max<size_t>(1, versions);
+  while (log.size() > log_limit) log.pop_front();
+}
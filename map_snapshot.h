@@ -0,0 +1,96 @@
+#ifndef PATH_FINDING_VISUALIZER_MAP_SNAPSHOT_H
+#define PATH_FINDING_VISUALIZER_MAP_SNAPSHOT_H
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+#include "base.h"
+
+// 带版本的地图快照, 用于编辑者和多个寻路线程同时工作.
+//
+// 每个版本是一个不可修改的 MapSnapshot, 方格按 TILE x TILE 分块存储,
+// 分块由 shared_ptr 持有. 发布新版本时只复制被修改的方格所在的分块,
+// 其余分块和上一个版本共享 (写时复制), 所以一次发布的代价和修改的分块数成正比.
+// 当前版本的指针是原子地替换的: 读者取一次 Current() 就固定了这个版本,
+// 之后编辑者发布的新版本不会影响它, 它持有的分块在它释放之前也不会被回收.
+//
+// 算法仍然只读 GRID_MAP. 由持有算法的线程在两次寻路之间, 用 Sync
+// 把 GRID_MAP 推进到它固定的版本, 同时得到两个版本之间的变化,
+// 交给算法的 HandleMapChanges 增量处理 (比如 LPA*, D* Lite).
+// 其他线程只发布新版本, 从不直接修改 GRID_MAP.
+
+// 两个版本之间的变化, 格式和 Algorithm::HandleMapChanges 的参数相同
+struct MapChanges {
+  std::vector<Point> to_become_obstacles, to_remove_obstacles;
+  bool Empty() const {
+    return to_become_obstacles.empty() && to_remove_obstacles.empty();
+  }
+};
+
+// 地图的一个版本, 创建之后不可修改, 可以在多个线程之间共享
+class MapSnapshot {
+ public:
+  static constexpr int TILE = 64;
+  using Tile = std::vector<unsigned char>;
+
+  uint64_t Version() const { return version; }
+  int Rows() const { return M; }
+  int Cols() const { return N; }
+  unsigned char Get(int i, int j) const {
+    const auto &tile = *tiles[i / TILE * tile_cols + j / TILE];
+    return tile[i % TILE * TILE + j % TILE];
+  }
+  // 和 other 共享的分块数
+  int SharedTiles(const MapSnapshot &other) const;
+
+ private:
+  friend class VersionedMap;
+  uint64_t version = 0;
+  int M = 0, N = 0, tile_cols = 0;
+  // 按行优先存储的分块, 边缘分块越界的部分也占位
+  std::vector<std::shared_ptr<const Tile>> tiles;
+};
+
+// 地图的版本序列, 以及相邻版本之间的变更日志. 线程安全
+class VersionedMap {
+ public:
+  // 用 map 的当前内容创建一个新版本, 清空变更日志.
+  // 不支持分块存储的地图 (太大, 不适合整体复制), 此时返回 -1
+  int Reset(const GridMap &map);
+  // 当前版本, 没有 Reset 过时是 nullptr.
+  // 一次查询开始时取一次, 之后一直使用它
+  std::shared_ptr<const MapSnapshot> Current() const { return current.load(); }
+  // 发布一个新版本: changes 中的方格分别变成障碍物和空白方格.
+  // 值没有变化的方格会被忽略, 全部被忽略时不产生新版本.
+  // 多个编辑者可以同时调用, 按调用的顺序依次生效. 返回发布后的当前版本号
+  uint64_t Publish(const MapChanges &changes);
+  // 从版本 from 到版本 to 的变化 (合并后的, 改了又改回来的方格不出现).
+  // 日志中没有这一段时返回 -1
+  int ChangesBetween(uint64_t from, uint64_t to, MapChanges &changes) const;
+  // 把 map 从版本 from 修改成 to (用 GridMap::Set, 邻居位掩码也会修正),
+  // 修改的方格写到 changes. 日志中没有这一段时 (比如 from 是 0),
+  // 逐个方格和 to 比较. map 的尺寸和 to 不同时返回 -1
+  int Sync(GridMap &map, uint64_t from, const MapSnapshot &to,
+           MapChanges &changes) const;
+  // 最多保留多少个版本的变更日志, 默认 1024
+  void SetLogLimit(size_t versions);
+
+ private:
+  std::atomic<std::shared_ptr<const MapSnapshot>> current;
+  // 保护发布和日志
+  mutable std::mutex mu;
+  // {版本 v, 从 v-1 到 v 的变化}, 按版本递增
+  std::deque<std::pair<uint64_t, MapChanges>> log;
+  size_t log_limit = 1024;
+  // 最近一次分配的版本号, Reset 之后也继续递增, 不会重复
+  uint64_t last_version = 0;
+};
+
+extern VersionedMap MAP_VERSIONS;
+
+#endif
@@ -0,0 +1,86 @@
+#include "movingai.h"
+
+#include <spdlog/spdlog.h>
+
+#include <fstream>
+#include <sstream>
+
+bool IsMovingAIMapFile(const std::string &filepath) {
+  std::ifstream f(filepath);
+  std::string word;
+  return (f >> word) && word == "type";
+}
+
+int LoadMovingAIMap(const std::string &filepath) {
+  std::ifstream f(filepath);
+  if (!f) {
+    spdlog::error("地图: 无法打开文件 {}", filepath);
+    return -1;
+  }
+  // 头部: type, height, width, 以 "map" 结束
+  int m = -1, n = -1;
+  std::string key;
+  while (f >> key && key != "map") {
+    if (key == "height") {
+      f >> m;
+    } else if (key == "width") {
+      f >> n;
+    } else if (key == "type") {
+      std::string type;
+      f >> type;
+      if (type != "octile") spdlog::warn("地图: 未知的 MovingAI 类型 {}", type);
+    }
+  }
+  if (key != "map" || m <= 0 || n <= 0) {
+    spdlog::error("地图: MovingAI 地图的头部不完整 {}", filepath);
+    return -1;
+  }
+  GRID_MAP.Resize(m, n);
+  std::string line;
+  std::getline(f, line);  // "map" 所在行的剩余部分
+  for (int i = 0; i < m; i++) {
+    if (!std::getline(f, line)) {
+      spdlog::error("地图: MovingAI 地图应有 {} 行, 实际只有 {} 行", m, i);
+      return -1;
+    }
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+    if (line.size() != static_cast<size_t>(n)) {
+      spdlog::error("地图: MovingAI 地图第 {} 行应有 {} 个字符, 实际是 {} 个",
+                    i, n, line.size());
+      return -1;
+    }
+    for (int j = 0; j < n; j++) {
+      auto ch = line[j];
+      GRID_MAP[i][j] = (ch == '.' || ch == 'G' || ch == 'S') ? 0 : 1;
+    }
+  }
+  return 0;
+}
+
+int LoadMovingAIScenario(const std::string &filepath,
+                         std::vector<ScenarioQuery> &queries) {
+  std::ifstream f(filepath);
+  if (!f) {
+    spdlog::error("测试集: 无法打开文件 {}", filepath);
+    return -1;
+  }
+  std::string line;
+  int no = 0;
+  while (std::getline(f, line)) {
+    no++;
+    if (line.empty() || line.rfind("version", 0) == 0) continue;
+    // bucket map width height start_x start_y goal_x goal_y optimal
+    std::istringstream ss(line);
+    ScenarioQuery q;
+    int width, height, sx, sy, gx, gy;
+    if (!(ss >> q.bucket >> q.map >> width >> height >> sx >> sy >> gx >> gy >>
+          q.optimal)) {
+      spdlog::error("测试集: 第 {} 行格式错误: {}", no, line);
+      return -1;
+    }
+    q.start = {sy, sx};
+    q.target = {gy, gx};
+    queries.push_back(q);
+  }
+  return 0;
+}
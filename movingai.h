@@ -0,0 +1,45 @@
+#ifndef PATH_FINDING_VISUALIZER_MOVINGAI_H
+#define PATH_FINDING_VISUALIZER_MOVINGAI_H
+
+#include <string>
+#include <vector>
+
+#include "base.h"
+
+// MovingAI 格子地图测试集 (https://movingai.com/benchmarks/grids.html)
+//
+// .map 文件:
+//
+//   type octile
+//   height 12
+//   width 15
+//   map
+//   ..@@T....
+//
+// 其中 '.', 'G', 'S' 是可通行的, 其他 ('@', 'O', 'T', 'W') 都算作障碍物.
+//
+// .scen 文件, 第一行是 "version 1", 之后每行一个查询:
+//
+//   bucket map width height start_x start_y goal_x goal_y optimal_length
+//
+// 注意 x 是列, y 是行. optimal_length 按对角代价 sqrt(2) 计算,
+// 且不允许斜穿障碍物的拐角; 而这里的对角代价是 DIAGONAL_COST/COST_UNIT (1.4),
+// 且允许斜穿拐角, 因此对比时会有小的偏差.
+
+// 一个测试查询
+struct ScenarioQuery {
+  int bucket;
+  std::string map;
+  Point start, target;  // (行, 列)
+  double optimal;       // 测试集给出的最优路径长度
+};
+
+// 文件是否是 MovingAI 格式的地图 (以 "type" 开头)
+bool IsMovingAIMapFile(const std::string &filepath);
+// 加载 MovingAI 格式的地图到 GRID_MAP, 成功返回 0
+int LoadMovingAIMap(const std::string &filepath);
+// 加载 .scen 文件中的全部查询, 成功返回 0
+int LoadMovingAIScenario(const std::string &filepath,
+                         std::vector<ScenarioQuery> &queries);
+
+#endif
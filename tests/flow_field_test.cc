@@ -0,0 +1,64 @@
+#include <spdlog/spdlog.h>
+
+#include "../algorithms/registry.h"
+#include "testing.h"
+
+// 计算到结束后的流场
+static const Grid<signed char> &flowsOf(Algorithm *algo, Blackboard &b) {
+  RunToEnd(algo, b);
+  return *b.flows;
+}
+
+// 地图修改后, 增量修正的流场要和在修改后的地图上重新计算的流场完全相同
+static bool testFlowFieldRepair() {
+  std::mt19937 rng(17);
+  for (bool use_4directions : {true, false}) {
+    RandomMap(30, 50, 0.25, rng);
+    Options options;
+    options.use_4directions = use_4directions;
+    // 不缓存, 否则重新计算会直接取到修正后的流场
+    options.flow_cache_mb = 0;
+    options.start = RandomFreeCell(rng);
+    options.target = RandomFreeCell(rng);
+    auto algo = AlgorithmMakers["flow-field"]();
+    Blackboard b;
+    algo->Setup(b, options);
+    flowsOf(algo.get(), b);
+    for (int round = 0; round < 50; round++) {
+      // 每次翻转几个方格, 起点和终点除外
+      std::vector<Point> to_become_obstacles, to_remove_obstacles;
+      for (int k = 0; k < 3; k++) {
+        Point p = {static_cast<int>(rng() % GRID_MAP.Rows()),
+                   static_cast<int>(rng() % GRID_MAP.Cols())};
+        if (p == options.start || p == options.target) continue;
+        if (GRID_MAP.Get(p.first, p.second)) {
+          to_remove_obstacles.push_back(p);
+          GRID_MAP.Set(p.first, p.second, 0);
+        } else {
+          to_become_obstacles.push_back(p);
+          GRID_MAP.Set(p.first, p.second, 1);
+        }
+      }
+      algo->HandleMapChanges(b, options, to_become_obstacles,
+                             to_remove_obstacles);
+      const auto &repaired = flowsOf(algo.get(), b);
+      auto fresh = AlgorithmMakers["flow-field"]();
+      Blackboard fb;
+      fresh->Setup(fb, options);
+      const auto &expected = flowsOf(fresh.get(), fb);
+      for (int i = 0; i < GRID_MAP.Rows(); i++) {
+        for (int j = 0; j < GRID_MAP.Cols(); j++) {
+          if (repaired[i][j] == expected[i][j]) continue;
+          spdlog::error("flow-field: 第 {} 次修改后 ({},{}) 的流向是 {}, "
+                        "重新计算是 {}",
+                        round, i, j, repaired[i][j], expected[i][j]);
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+static bool registered =
+    RegisterTest("flow-field-repair", testFlowFieldRepair);
@@ -0,0 +1,42 @@
+#include <spdlog/spdlog.h>
+
+#include "../algorithms/flow_kernel.h"
+#include "testing.h"
+
+// 当前 CPU 支持的每一种 SIMD 实现, 结果都要和标量实现完全相同
+static bool testFlowKernels() {
+  std::mt19937 rng(20);
+  // 列数不是 SIMD 宽度的整数倍, 覆盖每行末尾的剩余部分
+  RandomMap(20, 77, 0.2, rng);
+  int M = GRID_MAP.Rows(), N = GRID_MAP.Cols();
+  // 随机的距离, 其中一些不可达
+  std::vector<int> dist(GRID_MAP.Size());
+  for (auto &d : dist) d = rng() % 10 == 0 ? inf : rng() % 2000;
+  std::vector<int> buffer(3 * (N + 2));
+  const int *rows[3] = {buffer.data(), buffer.data() + N + 2,
+                        buffer.data() + 2 * (N + 2)};
+  std::vector<signed char> expected(N), actual(N);
+  auto best = BestFlowKernel();
+  for (auto kernel : {FlowKernel::SSE41, FlowKernel::AVX2}) {
+    if (kernel > best) continue;
+    for (bool use_4directions : {true, false}) {
+      for (int i = 0; i < M; i++) {
+        for (int k = 0; k < 3; k++)
+          FillFlowRow(dist, i + k - 1, buffer.data() + k * (N + 2));
+        CalcFlowRow(FlowKernel::Scalar, rows, N, use_4directions,
+                    expected.data());
+        CalcFlowRow(kernel, rows, N, use_4directions, actual.data());
+        for (int j = 0; j < N; j++) {
+          if (actual[j] == expected[j]) continue;
+          spdlog::error("{}: ({},{}) 的流向是 {}, 标量实现是 {}",
+                        FlowKernelName(kernel), i, j, actual[j],
+                        expected[j]);
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+static bool registered = RegisterTest("flow-kernels", testFlowKernels);
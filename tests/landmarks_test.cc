@@ -0,0 +1,31 @@
+#include <spdlog/spdlog.h>
+
+#include "testing.h"
+
+// 地标启发是可采纳的, A* 用它找到的路径代价要和 Dijkstra 相同
+static bool testLandmarksOptimal() {
+  std::mt19937 rng(16);
+  for (bool use_4directions : {true, false}) {
+    RandomMap(40, 60, 0.3, rng);
+    Options options;
+    options.use_4directions = use_4directions;
+    options.astar_heuristic_method = "landmarks";
+    for (int k = 0; k < 100; k++) {
+      options.start = RandomFreeCell(rng);
+      options.target = RandomFreeCell(rng);
+      int cost = SearchCost("astar", options);
+      int expected = SearchCost("dijkstra", options);
+      if (cost != expected) {
+        spdlog::error("landmarks: {},{} => {},{} 代价 {}, dijkstra 是 {}",
+                      options.start.first, options.start.second,
+                      options.target.first, options.target.second, cost,
+                      expected);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static bool registered =
+    RegisterTest("landmarks-optimal", testLandmarksOptimal);
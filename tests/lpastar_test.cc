@@ -0,0 +1,50 @@
+#include <spdlog/spdlog.h>
+
+#include "../algorithms/registry.h"
+#include "testing.h"
+
+// 地图修改后, LPA* 用带索引的堆增量修正的结果,
+// 要和在修改后的地图上重新搜索的最短路代价相同
+static bool testLPAStarIncremental() {
+  std::mt19937 rng(10);
+  for (bool use_4directions : {true, false}) {
+    RandomMap(30, 50, 0.25, rng);
+    Options options;
+    options.use_4directions = use_4directions;
+    options.astar_heuristic_method =
+        use_4directions ? "manhattan" : "euclidean";
+    options.start = RandomFreeCell(rng);
+    options.target = RandomFreeCell(rng);
+    auto algo = AlgorithmMakers["lpastar"]();
+    Blackboard b;
+    algo->Setup(b, options);
+    RunToEnd(algo.get(), b);
+    for (int round = 0; round < 100; round++) {
+      // 翻转一个方格, 起点和终点除外
+      Point p = RandomFreeCell(rng);
+      if (rng() % 2)
+        p = {static_cast<int>(rng() % GRID_MAP.Rows()),
+             static_cast<int>(rng() % GRID_MAP.Cols())};
+      if (p == options.start || p == options.target) continue;
+      std::vector<Point> to_become_obstacles, to_remove_obstacles;
+      if (GRID_MAP.Get(p.first, p.second))
+        to_remove_obstacles.push_back(p);
+      else
+        to_become_obstacles.push_back(p);
+      GRID_MAP.Set(p.first, p.second, !GRID_MAP.Get(p.first, p.second));
+      algo->HandleMapChanges(b, options, to_become_obstacles,
+                             to_remove_obstacles);
+      int cost = RunToEnd(algo.get(), b) == 0 ? PathCost(b.path) : -1;
+      int expected = SearchCost("dijkstra", options);
+      if (cost != expected) {
+        spdlog::error("lpastar: 第 {} 次修改后代价 {}, 重新搜索是 {}", round,
+                      cost, expected);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static bool registered =
+    RegisterTest("lpastar-incremental", testLPAStarIncremental);
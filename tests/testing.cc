@@ -0,0 +1,70 @@
+#include "testing.h"
+
+#include <spdlog/spdlog.h>
+
+#include <cstdio>
+#include <map>
+
+#include "../algorithms/registry.h"
+
+// 按名字排列, 执行顺序固定
+static std::map<std::string, std::function<bool()>> &tests() {
+  static std::map<std::string, std::function<bool()>> all;
+  return all;
+}
+
+bool RegisterTest(const std::string &name, std::function<bool()> fn) {
+  tests()[name] = std::move(fn);
+  return true;
+}
+
+void RandomMap(int m, int n, double density, std::mt19937 &rng) {
+  std::bernoulli_distribution obstacle(density);
+  GRID_MAP.Resize(m, n);
+  for (int i = 0; i < m; i++)
+    for (int j = 0; j < n; j++)
+      if (obstacle(rng)) GRID_MAP.Set(i, j, 1);
+}
+
+Point RandomFreeCell(std::mt19937 &rng) {
+  Point p;
+  do {
+    p = {static_cast<int>(rng() % GRID_MAP.Rows()),
+         static_cast<int>(rng() % GRID_MAP.Cols())};
+  } while (GRID_MAP.Get(p.first, p.second));
+  return p;
+}
+
+int RunToEnd(Algorithm *algo, Blackboard &b) {
+  int code;
+  StepUsage used;
+  while ((code = algo->Step(b, {}, used)) == -1) {
+  }
+  return code;
+}
+
+int SearchCost(const std::string &algorithm, const Options &options) {
+  auto algo = AlgorithmMakers[algorithm]();
+  Blackboard b;
+  algo->Setup(b, options);
+  if (RunToEnd(algo.get(), b) != 0) return -1;
+  return PathCost(b.path);
+}
+
+int main(int argc, char *argv[]) {
+  // 算法的日志太多, 只输出警告和测试失败的信息
+  spdlog::set_level(spdlog::level::warn);
+  std::string only = argc > 1 ? argv[1] : "";
+  if (!only.empty() && tests().find(only) == tests().end()) {
+    spdlog::error("找不到测试: {}", only);
+    return 1;
+  }
+  int failed = 0;
+  for (const auto &[name, fn] : tests()) {
+    if (!only.empty() && name != only) continue;
+    bool ok = fn();
+    std::printf("[%s] %s\n", ok ? "PASS" : "FAIL", name.c_str());
+    failed += !ok;
+  }
+  return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,28 @@
+#ifndef PATH_FINDING_VISUALIZER_TESTS_TESTING_H
+#define PATH_FINDING_VISUALIZER_TESTS_TESTING_H
+
+#include <functional>
+#include <random>
+#include <string>
+
+#include "../algorithms/algorithm_base.h"
+#include "../base.h"
+
+// 极简的测试框架, 不依赖第三方库.
+// 每个测试是一个返回是否通过的函数, 在静态初始化时用 RegisterTest 注册.
+// ctest 对每个测试单独执行一次 path-finding-tests <测试名>,
+// 不带参数时执行全部测试.
+
+// 注册一个测试, 返回值只用于静态初始化
+bool RegisterTest(const std::string &name, std::function<bool()> fn);
+
+// 在 GRID_MAP 上生成 m*n 的随机地图, 每个方格以 density 的概率是障碍物
+void RandomMap(int m, int n, double density, std::mt19937 &rng);
+// 随机选一个可通行的方格
+Point RandomFreeCell(std::mt19937 &rng);
+// 把算法执行到结束, 返回 Step 的结果 (0 成功, -2 失败)
+int RunToEnd(Algorithm *algo, Blackboard &b);
+// 用一个新的 algorithm 实例从头寻路, 返回路径的代价, 失败返回 -1
+int SearchCost(const std::string &algorithm, const Options &options);
+
+#endif
@@ -0,0 +1,89 @@
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <filesystem>
+#include <vector>
+
+#include "../algorithms/registry.h"
+#include "../binary_map.h"
+#include "testing.h"
+
+// 分块地图上的短查询只加载起点和终点附近的分块:
+// 常驻的分块数不超过 --tile-budget, 读入的分块数远小于分块总数,
+// 并且代价和整张地图都在内存中时相同
+static bool testTiledMapResidency() {
+  const int ROWS = 1024, COLS = 1024, TILE_SIZE = 64, BUDGET = 16;
+  const int TOTAL_TILES = (ROWS / TILE_SIZE) * (COLS / TILE_SIZE);
+  std::mt19937 rng(3);
+  RandomMap(ROWS, COLS, 0.2, rng);
+  GRID_MAP.Set(100, 100, 0);
+  GRID_MAP.Set(130, 170, 0);
+
+  struct Case {
+    const char *algorithm;
+    bool use_4directions;
+    int expected;
+  };
+  std::vector<Case> cases;
+  for (const char *algorithm : {"dijkstra", "astar", "jps", "astar-bi"}) {
+    for (bool use_4directions : {true, false}) {
+      Options options;
+      options.use_4directions = use_4directions;
+      options.astar_heuristic_method =
+          use_4directions ? "manhattan" : "euclidean";
+      options.start = {100, 100};
+      options.target = {130, 170};
+      cases.push_back(
+          {algorithm, use_4directions, SearchCost(algorithm, options)});
+    }
+  }
+
+  auto path = (std::filesystem::temp_directory_path() /
+               ("tiled_map_test_" + std::to_string(::getpid()) + ".pfvm"))
+                  .string();
+  if (SaveBinaryMap(path, GRID_MAP, BINARY_MAP_ENCODING_TILED, TILE_SIZE) !=
+      0)
+    return false;
+  int code = LoadMap(path, BUDGET);
+  // 分块存储持有打开的文件, 可以直接删除
+  std::remove(path.c_str());
+  if (code != 0 || GRID_MAP.Tiles() == nullptr) {
+    spdlog::error("tiled-map: 加载分块地图失败");
+    return false;
+  }
+
+  for (const auto &c : cases) {
+    Options options;
+    options.use_4directions = c.use_4directions;
+    options.astar_heuristic_method =
+        c.use_4directions ? "manhattan" : "euclidean";
+    options.start = {100, 100};
+    options.target = {130, 170};
+    auto algo = AlgorithmMakers[c.algorithm]();
+    if (!algo->SupportsTiledMap(options)) {
+      spdlog::error("tiled-map: {} 应该支持分块地图", c.algorithm);
+      return false;
+    }
+    auto misses = GRID_MAP.Tiles()->GetStats().misses;
+    Blackboard b;
+    algo->Setup(b, options);
+    int cost = RunToEnd(algo.get(), b) == 0 ? PathCost(b.path) : -1;
+    misses = GRID_MAP.Tiles()->GetStats().misses - misses;
+    int resident = GRID_MAP.Tiles()->Resident();
+    if (cost != c.expected) {
+      spdlog::error("tiled-map: {} ({} 方向) 代价 {}, 应该是 {}", c.algorithm,
+                    c.use_4directions ? 4 : 8, cost, c.expected);
+      return false;
+    }
+    if (resident > BUDGET || misses * 4 > TOTAL_TILES) {
+      spdlog::error("tiled-map: {} ({} 方向) 常驻 {} 个分块, 读入 {} 个",
+                    c.algorithm, c.use_4directions ? 4 : 8, resident, misses);
+      return false;
+    }
+  }
+  return true;
+}
+
+static bool registered =
+    RegisterTest("tiled-map-residency", testTiledMapResidency);
@@ -0,0 +1,120 @@
+#include "tile_store.h"
+
+#include <spdlog/spdlog.h>
+#include <unistd.h>
+
+#include <algorithm>
+
+TileStore::TileStore(int fd, size_t offset, int rows, int cols, int tile_size,
+                     int budget)
+    : fd(fd),
+      file_offset(offset),
+      tile_size(tile_size),
+      mask(tile_size - 1),
+      budget(std::max(budget, 1)) {
+  shift = 0;
+  while ((1 << shift) < tile_size) shift++;
+  tiles_per_row = (cols + tile_size - 1) / tile_size;
+  int tiles_per_col = (rows + tile_size - 1) / tile_size;
+  tile_slot.assign(static_cast<size_t>(tiles_per_row) * tiles_per_col, -1);
+}
+
+TileStore::~TileStore() { close(fd); }
+
+void TileStore::Set(int i, int j, unsigned char value) {
+  int id = tileId(i, j);
+  tile(i, j)[offset(i, j)] = value;
+  // 修改过的分块常驻内存
+  slot_dirty[tile_slot[id]] = true;
+}
+
+void TileStore::SetBudget(int budget) {
+  this->budget = std::max(budget, 1);
+  // 从尾部淘汰, 直到满足预算 (跳过修改过的分块)
+  for (int slot = tail; slot != -1 && resident > this->budget;) {
+    int prev = slot_prev[slot];
+    if (!slot_dirty[slot]) {
+      unlink(slot);
+      tile_slot[slot_tile[slot]] = -1;
+      slot_tile[slot] = -1;
+      std::vector<unsigned char>().swap(slot_data[slot]);
+      free_slots.push_back(slot);
+      resident--;
+      stats.evictions++;
+    }
+    slot = prev;
+  }
+  last_tile = -1;
+}
+
+unsigned char *TileStore::touch(int id) {
+  int slot = tile_slot[id];
+  if (slot != -1) {
+    stats.hits++;
+    unlink(slot);
+    pushFront(slot);
+  } else {
+    stats.misses++;
+    slot = acquireSlot();
+    auto &data = slot_data[slot];
+    data.resize(static_cast<size_t>(tile_size) * tile_size);
+    off_t pos = file_offset + static_cast<off_t>(id) * data.size();
+    if (pread(fd, data.data(), data.size(), pos) !=
+        static_cast<ssize_t>(data.size())) {
+      // 读取失败时当作全是障碍物, 以免搜索走到未知区域
+      spdlog::error("分块地图: 读取分块 {} 失败", id);
+      std::fill(data.begin(), data.end(), 1);
+    }
+    slot_tile[slot] = id;
+    slot_dirty[slot] = false;
+    tile_slot[id] = slot;
+    pushFront(slot);
+  }
+  last_tile = id;
+  last_data = slot_data[slot].data();
+  return last_data;
+}
+
+int TileStore::acquireSlot() {
+  if (resident >= budget) {
+    // 从尾部找最久未使用的, 且没有修改过的分块淘汰
+    for (int slot = tail; slot != -1; slot = slot_prev[slot]) {
+      if (slot_dirty[slot]) continue;
+      unlink(slot);
+      tile_slot[slot_tile[slot]] = -1;
+      stats.evictions++;
+      return slot;
+    }
+    // 全部是修改过的分块, 只能超出预算
+  }
+  // 新开一个槽位 (优先复用之前 SetBudget 腾出来的槽位)
+  resident++;
+  if (!free_slots.empty()) {
+    int slot = free_slots.back();
+    free_slots.pop_back();
+    return slot;
+  }
+  slot_data.emplace_back();
+  slot_tile.push_back(-1);
+  slot_prev.push_back(-1);
+  slot_next.push_back(-1);
+  slot_dirty.push_back(false);
+  return slot_tile.size() - 1;
+}
+
+void TileStore::unlink(int slot) {
+  int prev = slot_prev[slot], next = slot_next[slot];
+  if (prev != -1) slot_next[prev] = next;
+  if (next != -1) slot_prev[next] = prev;
+  if (head == slot) head = next;
+  if (tail == slot) tail = prev;
+  slot_prev[slot] = slot_next[slot] = -1;
+}
+
+void TileStore::pushFront(int slot) {
+  slot_next[slot] = head;
+  slot_prev[slot] = -1;
+  if (head != -1) slot_prev[head] = slot;
+  head = slot;
+  if (tail == -1) tail = slot;
+}
@@ -0,0 +1,88 @@
+#ifndef PATH_FINDING_VISUALIZER_TILE_STORE_H
+#define PATH_FINDING_VISUALIZER_TILE_STORE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// 分块地图存储: 地图被切成固定大小的正方形分块 (比如 64x64),
+// 分块在第一次被访问时才从磁盘读入, 常驻的分块数量超过预算时, 按 LRU 淘汰.
+// 这样一次搜索只需要加载它实际访问到的分块, 而不要求整张地图常驻内存.
+//
+// 被修改过的分块 (Set) 不会被淘汰, 因为修改不写回文件.
+// 非线程安全.
+class TileStore {
+ public:
+  // 计数器
+  struct Stats {
+    uint64_t hits = 0;       // 访问时分块已经在内存中
+    uint64_t misses = 0;     // 访问时分块需要从磁盘读入
+    uint64_t evictions = 0;  // 淘汰的分块数
+  };
+
+  // fd: 地图文件, 由 TileStore 持有并负责关闭
+  // offset: 第一个分块在文件中的偏移, 分块按行优先依次存储,
+  //   每个分块 tile_size*tile_size 字节 (边缘分块越界的部分也占位)
+  // tile_size: 分块边长, 必须是 2 的幂
+  // budget: 最多常驻的分块数量
+  TileStore(int fd, size_t offset, int rows, int cols, int tile_size,
+            int budget);
+  ~TileStore();
+  TileStore(const TileStore &) = delete;
+  TileStore &operator=(const TileStore &) = delete;
+
+  unsigned char Get(int i, int j) { return tile(i, j)[offset(i, j)]; }
+  void Set(int i, int j, unsigned char value);
+
+  // 调整常驻预算, 超出的分块会被立即淘汰
+  void SetBudget(int budget);
+  int TileSize() const { return tile_size; }
+  // 当前常驻的分块数
+  int Resident() const { return resident; }
+  const Stats &GetStats() const { return stats; }
+
+ private:
+  int fd;
+  size_t file_offset;
+  int tile_size, shift, mask;
+  int tiles_per_row;
+  int budget;
+  int resident = 0;
+  Stats stats;
+
+  // 按槽位存储的常驻分块, 以及槽位之间的 LRU 双向链表 (head 最近使用)
+  std::vector<std::vector<unsigned char>> slot_data;
+  std::vector<int> slot_tile, slot_prev, slot_next;
+  std::vector<bool> slot_dirty;
+  // SetBudget 腾出来的空槽位
+  std::vector<int> free_slots;
+  int head = -1, tail = -1;
+  // tile_slot[分块号] => 槽位, 不在内存中是 -1
+  std::vector<int> tile_slot;
+  // 最近一次访问的分块, 连续访问同一个分块时的快速路径
+  int last_tile = -1;
+  unsigned char *last_data = nullptr;
+
+  int tileId(int i, int j) const {
+    return (i >> shift) * tiles_per_row + (j >> shift);
+  }
+  int offset(int i, int j) const {
+    return ((i & mask) << shift) + (j & mask);
+  }
+  unsigned char *tile(int i, int j) {
+    int id = tileId(i, j);
+    if (id == last_tile) {
+      stats.hits++;
+      return last_data;
+    }
+    return touch(id);
+  }
+  // 访问一个分块, 不在内存则加载, 并移动到 LRU 的头部
+  unsigned char *touch(int id);
+  // 找一个槽位装入分块, 必要时淘汰最久未使用的分块
+  int acquireSlot();
+  void unlink(int slot);
+  void pushFront(int slot);
+};
+
+#endif
@@ -0,0 +1,49 @@
+// 压缩路径数据库 (CPD) 的离线构建工具: 从每个出发点做一次 dijkstra,
+// 保存到每个目标的最短路的第一步 (见 algorithms/cpd.h).
+// 出发点分给多个线程并行计算.
+//
+//   ./build/cpd-builder arena.map arena.cpd
+//   ./build/cpd-builder -d4 --threads 8 arena.map arena-d4.cpd
+
+#include <spdlog/spdlog.h>
+
+#include <argparse/argparse.hpp>
+#include <thread>
+
+#include "../algorithms/cpd.h"
+#include "../base.h"
+
+int main(int argc, char *argv[]) {
+  std::string input, output;
+  bool use_4directions = false;
+  int threads = std::thread::hardware_concurrency();
+
+  argparse::ArgumentParser program("cpd-builder");
+  program.add_argument("input").help("地图文件").store_into(input);
+  program.add_argument("output").help("输出的数据库文件").store_into(output);
+  program.add_argument("-d4", "--use-4-directions")
+      .help("只使用 4 方向 (默认是 8 方向)")
+      .default_value(false)
+      .store_into(use_4directions);
+  program.add_argument("--threads")
+      .help("并行构建的线程数, 默认是 CPU 核数")
+      .default_value(threads)
+      .store_into(threads);
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::exception &e) {
+    spdlog::error(e.what());
+    return 1;
+  }
+
+  if (LoadMap(input) != 0) return 1;
+  spdlog::info("地图加载成功 ({}, {}x{})", input, GRID_MAP.Rows(),
+               GRID_MAP.Cols());
+
+  CompressedPathDatabase db;
+  if (db.Build(use_4directions, threads) != 0) return 1;
+  if (db.Save(output) != 0) return 1;
+  spdlog::info("已保存压缩路径数据库 => {}", output);
+  return 0;
+}
@@ -0,0 +1,48 @@
+// 地图转换工具: 把文本格式的地图 (比如 map.txt) 转换为二进制格式
+//
+//   ./build/map-converter map.txt map.pfvm
+//   ./build/map-converter --bit-packed map.txt map.pfvm
+//   ./build/map-converter --tile-size 64 map.txt map.pfvm
+
+#include <spdlog/spdlog.h>
+
+#include <argparse/argparse.hpp>
+
+#include "../base.h"
+#include "../binary_map.h"
+
+int main(int argc, char *argv[]) {
+  std::string input, output;
+  bool bit_packed = false;
+  int tile_size = 0;
+
+  argparse::ArgumentParser program("map-converter");
+  program.add_argument("input").help("输入的文本地图文件").store_into(input);
+  program.add_argument("output").help("输出的二进制地图文件").store_into(output);
+  program.add_argument("--bit-packed")
+      .help("每个方格一个 bit (默认是每个方格一个字节, 可以直接 mmap)")
+      .default_value(false)
+      .store_into(bit_packed);
+  program.add_argument("--tile-size")
+      .help("分块存储的分块边长 (2 的幂), 加载时按需读入分块, 0 表示不分块")
+      .default_value(0)
+      .store_into(tile_size);
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::exception &e) {
+    spdlog::error(e.what());
+    return 1;
+  }
+
+  if (LoadMap(input) != 0) return 1;
+  spdlog::info("地图加载成功 ({}, {}x{})", input, GRID_MAP.Rows(),
+               GRID_MAP.Cols());
+
+  auto encoding =
+      bit_packed ? BINARY_MAP_ENCODING_BIT : BINARY_MAP_ENCODING_BYTE;
+  if (tile_size > 0) encoding = BINARY_MAP_ENCODING_TILED;
+  if (SaveBinaryMap(output, GRID_MAP, encoding, tile_size) != 0) return 1;
+  spdlog::info("已保存二进制地图 => {}", output);
+  return 0;
+}
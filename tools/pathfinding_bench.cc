@@ -0,0 +1,330 @@
+// 性能基准: 对每个注册的算法, 在给定的地图和随机的 (起点, 终点) 上执行寻路,
+// 以 JSON 格式输出延迟的中位数和 p99, 每秒扩展的节点数, 以及堆内存的峰值.
+// 4 方向和 8 方向分开统计. 可以用来对比两次构建之间的性能.
+// --open-lists 可以同时测试多种开放列表的实现 (见 algorithms/open_list.h).
+// --frame-us 模拟游戏的每一帧限时寻路: 每次 Step 最多执行这么多微秒,
+// 输出每次寻路平均需要的帧数和最长的一帧.
+//
+//   ./build/pathfinding-bench --maps map.txt arena.map --queries 50 > bench.json
+
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+#include <algorithm>
+#include <argparse/argparse.hpp>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <new>
+#include <random>
+
+#include "../algorithms/registry.h"
+#include "../base.h"
+
+/////////////////////////////////////
+/// 堆内存统计: 替换全局的 operator new/delete
+/////////////////////////////////////
+
+// 每次分配前面放一个头部记录大小, 保持 max_align_t 对齐
+static const size_t HEAP_HEADER = alignof(std::max_align_t);
+static std::atomic<size_t> heap_current = 0, heap_peak = 0;
+
+// 记录一次分配, 维护当前的用量和峰值
+static void heapAdd(size_t size) {
+  size_t current = heap_current += size;
+  size_t peak = heap_peak.load();
+  while (current > peak && !heap_peak.compare_exchange_weak(peak, current));
+}
+
+void *operator new(size_t size) {
+  auto *p = static_cast<char *>(std::malloc(size + HEAP_HEADER));
+  if (p == nullptr) throw std::bad_alloc();
+  *reinterpret_cast<size_t *>(p) = size;
+  heapAdd(size);
+  return p + HEAP_HEADER;
+}
+
+void operator delete(void *ptr) noexcept {
+  if (ptr == nullptr) return;
+  auto *p = static_cast<char *>(ptr) - HEAP_HEADER;
+  heap_current -= *reinterpret_cast<size_t *>(p);
+  std::free(p);
+}
+
+// 对齐要求超过 max_align_t 的类型 (alignas) 走这一组重载.
+// 头部放大到对齐的大小, 大小记录在紧挨着返回地址的前面
+static size_t alignedHeader(std::align_val_t align) {
+  return std::max(HEAP_HEADER, static_cast<size_t>(align));
+}
+
+void *operator new(size_t size, std::align_val_t align) {
+  size_t a = static_cast<size_t>(align), header = alignedHeader(align);
+  // aligned_alloc 要求大小是对齐的整数倍
+  size_t total = (header + size + a - 1) / a * a;
+  auto *p = static_cast<char *>(std::aligned_alloc(a, total));
+  if (p == nullptr) throw std::bad_alloc();
+  p += header;
+  *reinterpret_cast<size_t *>(p - sizeof(size_t)) = size;
+  heapAdd(size);
+  return p;
+}
+
+void operator delete(void *ptr, std::align_val_t align) noexcept {
+  if (ptr == nullptr) return;
+  auto *p = static_cast<char *>(ptr);
+  heap_current -= *reinterpret_cast<size_t *>(p - sizeof(size_t));
+  std::free(p - alignedHeader(align));
+}
+
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete[](void *ptr) noexcept { operator delete(ptr); }
+void operator delete(void *ptr, size_t) noexcept { operator delete(ptr); }
+void operator delete[](void *ptr, size_t) noexcept { operator delete(ptr); }
+void *operator new[](size_t size, std::align_val_t align) {
+  return operator new(size, align);
+}
+void operator delete[](void *ptr, std::align_val_t align) noexcept {
+  operator delete(ptr, align);
+}
+void operator delete(void *ptr, size_t, std::align_val_t align) noexcept {
+  operator delete(ptr, align);
+}
+void operator delete[](void *ptr, size_t, std::align_val_t align) noexcept {
+  operator delete(ptr, align);
+}
+
+/////////////////////////////////////
+/// 基准
+/////////////////////////////////////
+
+// 一组基准的结果 (一个地图, 一种方向数, 一个算法)
+struct BenchResult {
+  std::string map;
+  int directions = 0;
+  std::string algorithm;
+  std::string open_list;
+  int queries = 0;
+  int failed = 0;
+  std::vector<double> latencies_us;  // 每次执行的延迟 (Setup + 寻路)
+  long long expansions = 0;
+  long long stale_pops = 0;  // 开放列表的过期弹出数
+  double search_us = 0;  // 寻路部分的总耗时, 用于计算每秒扩展数
+  // 构造算法之前的堆内存用量
+  size_t heap_base = 0;
+  // 执行期间的堆内存峰值 (相对 heap_base, 包括算法持有的状态)
+  size_t peak_heap = 0;
+  // 总帧数 (Step 的调用次数) 和最长的一帧的耗时
+  long long frames = 0;
+  double max_frame_us = 0;
+};
+
+// 在地图上随机选 k 对可通行的 (起点, 终点)
+static std::vector<std::pair<Point, Point>> randomQueries(int k, int seed) {
+  std::vector<Point> cells;
+  for (int i = 0; i < GRID_MAP.Rows(); i++)
+    for (int j = 0; j < GRID_MAP.Cols(); j++)
+      if (!GRID_MAP.Get(i, j)) cells.push_back({i, j});
+  std::vector<std::pair<Point, Point>> queries;
+  if (cells.size() < 2) return queries;
+  std::mt19937 rng(seed);
+  std::uniform_int_distribution<size_t> pick(0, cells.size() - 1);
+  while (queries.size() < static_cast<size_t>(k)) {
+    auto s = cells[pick(rng)], t = cells[pick(rng)];
+    if (s != t) queries.push_back({s, t});
+  }
+  return queries;
+}
+
+// 执行一次寻路, 每一帧最多 frame_us 微秒 (0 表示一次执行到结束),
+// 返回是否成功
+static bool runOnce(Algorithm *algo, const Options &options, int frame_us,
+                    BenchResult &r, bool record) {
+  heap_peak = heap_current.load();
+  Blackboard b;
+  auto t0 = std::chrono::steady_clock::now();
+  algo->Setup(b, options);
+  auto t1 = std::chrono::steady_clock::now();
+  int code, frames = 0;
+  double max_frame_us = 0;
+  StepUsage used;
+  do {
+    code = algo->Step(b, {0, frame_us}, used);
+    frames++;
+    max_frame_us = std::max(max_frame_us, used.time_us);
+  } while (code == -1);
+  auto t2 = std::chrono::steady_clock::now();
+  if (record) {
+    r.latencies_us.push_back(
+        std::chrono::duration<double, std::micro>(t2 - t0).count());
+    r.search_us += std::chrono::duration<double, std::micro>(t2 - t1).count();
+    r.expansions += b.expansions;
+    r.stale_pops += b.stale_pops;
+    r.peak_heap = std::max(r.peak_heap, heap_peak.load() - r.heap_base);
+    r.frames += frames;
+    r.max_frame_us = std::max(r.max_frame_us, max_frame_us);
+  }
+  return code == 0;
+}
+
+static double percentile(std::vector<double> v, double p) {
+  if (v.empty()) return 0;
+  std::sort(v.begin(), v.end());
+  size_t k = std::min(v.size() - 1, static_cast<size_t>(p * v.size()));
+  return v[k];
+}
+
+static std::string jsonEscape(const std::string &s) {
+  std::string out;
+  for (auto ch : s) {
+    if (ch == '"' || ch == '\\') out.push_back('\\');
+    out.push_back(ch);
+  }
+  return out;
+}
+
+int main(int argc, char *argv[]) {
+  // 标准输出只留给结果, 日志都写到标准错误
+  spdlog::set_default_logger(std::make_shared<spdlog::logger>(
+      "", std::make_shared<spdlog::sinks::stderr_color_sink_mt>()));
+
+  std::vector<std::string> maps;
+  std::vector<std::string> algorithms;
+  std::vector<std::string> open_lists;
+  int queries = 20, warmup = 1, repeat = 5, seed = 1, frame_us = 0;
+  std::string output;
+
+  argparse::ArgumentParser program("pathfinding-bench");
+  program.add_argument("--maps")
+      .help("地图文件列表")
+      .nargs(argparse::nargs_pattern::at_least_one)
+      .store_into(maps);
+  program.add_argument("--algorithms")
+      .help("只测试这些算法, 默认全部")
+      .nargs(argparse::nargs_pattern::at_least_one)
+      .store_into(algorithms);
+  program.add_argument("--open-lists")
+      .help("开放列表的实现 heap 或者 bucket, 可以指定多个, 默认是 heap")
+      .nargs(argparse::nargs_pattern::at_least_one)
+      .store_into(open_lists);
+  program.add_argument("--queries")
+      .help("每张地图随机的 (起点, 终点) 数量")
+      .default_value(20)
+      .store_into(queries);
+  program.add_argument("--warmup")
+      .help("每个查询预热执行的次数 (不计入统计)")
+      .default_value(1)
+      .store_into(warmup);
+  program.add_argument("--repeat")
+      .help("每个查询计入统计的执行次数")
+      .default_value(5)
+      .store_into(repeat);
+  program.add_argument("--seed")
+      .help("随机数种子")
+      .default_value(1)
+      .store_into(seed);
+  program.add_argument("--frame-us")
+      .help("每一帧寻路的时间预算 (微秒), 0 表示一次执行到结束")
+      .default_value(0)
+      .store_into(frame_us);
+  program.add_argument("-o", "--output")
+      .help("JSON 输出文件, 默认是标准输出")
+      .default_value(std::string(""))
+      .store_into(output);
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::exception &e) {
+    spdlog::error(e.what());
+    return 1;
+  }
+  if (maps.empty()) maps.push_back("map.txt");
+  if (open_lists.empty()) open_lists.push_back("heap");
+  if (algorithms.empty()) {
+    for (const auto &[name, _] : AlgorithmMakers) algorithms.push_back(name);
+    std::sort(algorithms.begin(), algorithms.end());
+  }
+
+  std::vector<BenchResult> results;
+  for (const auto &map : maps) {
+    spdlog::set_level(spdlog::level::info);
+    if (LoadMap(map) != 0) return 1;
+    auto pairs = randomQueries(queries, seed);
+    spdlog::info("地图 {} ({}x{}), {} 个查询", map, GRID_MAP.Rows(),
+                 GRID_MAP.Cols(), pairs.size());
+    // 算法在每次 Setup 时的日志太多, 执行期间只输出警告
+    spdlog::set_level(spdlog::level::warn);
+    for (int directions : {4, 8}) {
+      for (const auto &name : algorithms) {
+        if (AlgorithmMakers.find(name) == AlgorithmMakers.end()) {
+          spdlog::error("找不到算法实现:  {}", name);
+          return 1;
+        }
+        for (const auto &open_list : open_lists) {
+          BenchResult r;
+          r.map = map;
+          r.directions = directions;
+          r.algorithm = name;
+          r.open_list = open_list;
+          r.heap_base = heap_current.load();
+          auto algo = AlgorithmMakers[name]();
+          Options options;
+          options.algorithm = name;
+          options.open_list = open_list;
+          options.use_4directions = directions == 4;
+          options.astar_heuristic_method =
+              directions == 4 ? "manhattan" : "euclidean";
+          if (GRID_MAP.Tiles() && !algo->SupportsTiledMap(options)) {
+            spdlog::warn("算法 {} 不支持分块地图, 跳过", name);
+            continue;
+          }
+          for (const auto &[s, t] : pairs) {
+            options.start = s;
+            options.target = t;
+            for (int k = 0; k < warmup; k++)
+              runOnce(algo.get(), options, frame_us, r, false);
+            bool ok = true;
+            for (int k = 0; k < repeat; k++)
+              ok = runOnce(algo.get(), options, frame_us, r, true) && ok;
+            r.queries++;
+            if (!ok) r.failed++;
+          }
+          results.push_back(std::move(r));
+        }
+      }
+    }
+  }
+
+  FILE *f = output.empty() ? stdout : std::fopen(output.c_str(), "w");
+  if (f == nullptr) {
+    spdlog::error("无法写入文件 {}", output);
+    return 1;
+  }
+  std::fprintf(f, "{\n  \"queries\": %d,\n  \"warmup\": %d,\n", queries,
+               warmup);
+  std::fprintf(f, "  \"repeat\": %d,\n  \"seed\": %d,\n  \"results\": [\n",
+               repeat, seed);
+  for (size_t k = 0; k < results.size(); k++) {
+    const auto &r = results[k];
+    double eps = r.search_us > 0 ? r.expansions / (r.search_us / 1e6) : 0;
+    double samples = std::max<size_t>(1, r.latencies_us.size());
+    std::fprintf(f,
+                 "    {\"map\": \"%s\", \"directions\": %d, \"algorithm\": "
+                 "\"%s\", \"open_list\": \"%s\", \"queries\": %d, "
+                 "\"failed\": %d, \"samples\": %zu, \"median_us\": %.2f, "
+                 "\"p99_us\": %.2f, \"expansions_per_sec\": %.0f, "
+                 "\"stale_pops\": %.1f, \"peak_heap_bytes\": %zu, "
+                 "\"frames\": %.1f, \"max_frame_us\": %.1f}%s\n",
+                 jsonEscape(r.map).c_str(), r.directions,
+                 jsonEscape(r.algorithm).c_str(), r.open_list.c_str(),
+                 r.queries, r.failed, r.latencies_us.size(),
+                 percentile(r.latencies_us, 0.5),
+                 percentile(r.latencies_us, 0.99), eps,
+                 r.stale_pops / samples, r.peak_heap, r.frames / samples,
+                 r.max_frame_us, k + 1 < results.size() ? "," : "");
+  }
+  std::fprintf(f, "  ]\n}\n");
+  if (f != stdout) std::fclose(f);
+  return 0;
+}
@@ -0,0 +1,235 @@
+// MovingAI 测试集执行工具: 用指定的算法执行 .scen 中的每一个查询,
+// 按 CSV 格式逐行输出每个查询的耗时, 扩展的节点数, 以及路径代价和最优代价的对比.
+//
+//   ./build/scenario-runner --algorithm astar arena.map.scen > astar.csv
+//
+// 默认在 .scen 文件所在目录下找地图文件, 可以用 --map-dir 或者 --map 指定.
+// --threads 大于 1 时, 同一张地图的查询分给多个线程执行 (见 batch_query.h),
+// 输出仍然按查询的顺序.
+// --edits 大于 0 时, 每执行完一个 bucket 就随机修改地图 (发布为新的快照版本,
+// 见 map_snapshot.h), 模拟游戏中地图在查询之间的变化.
+
+#include <spdlog/sinks/stdout_color_sinks.h>
+#include <spdlog/spdlog.h>
+
+#include <argparse/argparse.hpp>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <memory>
+#include <random>
+#include <unordered_set>
+
+#include "../algorithms/path_cache.h"
+#include "../base.h"
+#include "../batch_query.h"
+#include "../map_snapshot.h"
+#include "../movingai.h"
+
+int main(int argc, char *argv[]) {
+  // 标准输出只留给结果, 日志都写到标准错误
+  spdlog::set_default_logger(std::make_shared<spdlog::logger>(
+      "", std::make_shared<spdlog::sinks::stderr_color_sink_mt>()));
+
+  Options options;
+  std::string scen_file, map_file, map_dir;
+  int limit = 0, threads = 1, edits = 0;
+
+  argparse::ArgumentParser program("scenario-runner");
+  program.add_argument("scenario").help(".scen 文件").store_into(scen_file);
+  program.add_argument("-a", "--algorithm")
+      .help("算法名称")
+      .default_value(std::string("astar"))
+      .store_into(options.algorithm);
+  program.add_argument("--map")
+      .help("地图文件, 默认使用 .scen 中每个查询的地图")
+      .default_value(std::string(""))
+      .store_into(map_file);
+  program.add_argument("--map-dir")
+      .help("地图文件所在目录, 默认是 .scen 文件所在目录")
+      .default_value(std::string(""))
+      .store_into(map_dir);
+  program.add_argument("-d4", "--use-4-directions")
+      .help("是否只采用4方向,默认是8方向")
+      .default_value(false)
+      .store_into(options.use_4directions);
+  program.add_argument("-astar-w", "--astar-heuristic-weight")
+      .help("AStar/LPAStar 算法的启发式未来估价的权重倍数, 自然数")
+      .default_value(1)
+      .store_into(options.astar_heuristic_weight);
+  program.add_argument("-astar-m", "--astar-heuristic-method")
+      .help("AStar/LPAStar 算法的启发式方法, manhattan, euclidean 或者 "
+            "landmarks")
+      .default_value(std::string(""))
+      .store_into(options.astar_heuristic_method);
+  program.add_argument("--landmarks")
+      .help("地标启发的地标数量")
+      .default_value(8)
+      .store_into(options.landmark_count);
+  program.add_argument("--open-list")
+      .help("开放列表的实现, 二叉堆 heap 或者 桶队列 bucket")
+      .default_value(std::string("heap"))
+      .choices("heap", "bucket")
+      .store_into(options.open_list);
+  program.add_argument("--limit")
+      .help("最多执行的查询数量, 0 表示全部")
+      .default_value(0)
+      .store_into(limit);
+  program.add_argument("--threads")
+      .help("执行查询的线程数")
+      .default_value(1)
+      .store_into(threads);
+  program.add_argument("--path-cache")
+      .help("寻路结果缓存的容量 (条目数), 重复的查询直接取自缓存, 0 表示不缓存")
+      .default_value(0)
+      .store_into(options.path_cache_entries);
+  program.add_argument("--edits")
+      .help("每执行完一个 bucket, 随机翻转的方格数量, 0 表示不修改地图")
+      .default_value(0)
+      .store_into(edits);
+
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::exception &e) {
+    spdlog::error(e.what());
+    return 1;
+  }
+
+  if (options.astar_heuristic_method.empty())
+    options.astar_heuristic_method =
+        options.use_4directions ? "manhattan" : "euclidean";
+  BatchQueryRunner runner;
+  if (runner.Prepare(options, threads) != 0) return 1;
+  if (map_dir.empty())
+    map_dir = std::filesystem::path(scen_file).parent_path().string();
+
+  std::vector<ScenarioQuery> queries;
+  if (LoadMovingAIScenario(scen_file, queries) != 0) return 1;
+  if (limit > 0 && queries.size() > static_cast<size_t>(limit))
+    queries.resize(limit);
+  spdlog::info("加载了 {} 个查询, 算法 {}", queries.size(), options.algorithm);
+
+  // 算法在每次 Setup 时的日志太多, 执行期间只输出警告
+  spdlog::set_level(spdlog::level::warn);
+
+  std::printf(
+      "id,bucket,start_i,start_j,target_i,target_j,status,expansions,"
+      "stale_pops,setup_us,search_us,cost,optimal,ratio\n");
+
+  int failed = 0, suboptimal = 0;
+  long long total_expansions = 0;
+  double total_us = 0;
+
+  // 查询使用的地图文件
+  auto mapOf = [&](const ScenarioQuery &q) {
+    return map_file.empty() ? (std::filesystem::path(map_dir) /
+                               std::filesystem::path(q.map).filename())
+                                  .string()
+                            : map_file;
+  };
+  // 执行 [begin, end) 中的查询, 按顺序输出
+  auto runBatch = [&](int begin, int end) {
+    // 不合法的查询不执行, 其余的按下标记在 ids 中
+    std::vector<int> ids;
+    std::vector<Query> batch;
+    for (int id = begin; id < end; id++) {
+      const auto &q = queries[id];
+      options.start = q.start;
+      options.target = q.target;
+      if (ValidateStartAndTarget(options) != 0) continue;
+      ids.push_back(id);
+      batch.push_back({q.start, q.target});
+    }
+    std::vector<QueryResult> results;
+    if (edits > 0)
+      runner.Run(MAP_VERSIONS, batch, results);
+    else
+      runner.Run(batch, results);
+
+    for (int id = begin, k = 0; id < end; id++) {
+      const auto &q = queries[id];
+      if (k == static_cast<int>(ids.size()) || ids[k] != id) {
+        std::printf("%d,%d,%d,%d,%d,%d,invalid,0,0,0,0,0,%.4f,0\n", id,
+                    q.bucket, q.start.first, q.start.second, q.target.first,
+                    q.target.second, q.optimal);
+        failed++;
+        continue;
+      }
+      const auto &r = results[k++];
+      double cost = r.code == 0 ? r.cost / double(COST_UNIT) : 0;
+      double ratio = q.optimal > 0 ? cost / q.optimal : 1;
+      if (r.code != 0) failed++;
+      // 允许对角代价 1.4 和 sqrt(2) 之间的误差
+      if (r.code == 0 && ratio > 1.001) suboptimal++;
+      total_expansions += r.expansions;
+      total_us += r.setup_us + r.search_us;
+
+      std::printf("%d,%d,%d,%d,%d,%d,%s,%lld,%lld,%.1f,%.1f,%.4f,%.4f,%.4f\n",
+                  id, q.bucket, q.start.first, q.start.second, q.target.first,
+                  q.target.second, r.code == 0 ? "ok" : "failed",
+                  r.expansions, r.stale_pops, r.setup_us, r.search_us, cost,
+                  q.optimal, ratio);
+    }
+  };
+
+  // 随机修改地图用的随机数, 固定种子以便复现
+  std::mt19937 rng(1);
+
+  // 连续的使用同一张地图的查询作为一批执行
+  int total = queries.size();
+  for (int begin = 0, end; begin < total; begin = end) {
+    auto path = mapOf(queries[begin]);
+    end = begin + 1;
+    while (end < total && mapOf(queries[end]) == path) end++;
+    if (LoadMap(path) != 0) return 1;
+    // 修改地图时, 查询固定在当前的快照版本上执行.
+    // 起点和终点所在的方格不修改, 查询始终是合法的
+    std::unordered_set<int> endpoints;
+    if (edits > 0) {
+      if (MAP_VERSIONS.Reset(GRID_MAP) != 0) return 1;
+      for (int id = begin; id < end; id++) {
+        if (!ValidatePoint(queries[id].start) ||
+            !ValidatePoint(queries[id].target))
+          continue;
+        endpoints.insert(pack(queries[id].start));
+        endpoints.insert(pack(queries[id].target));
+      }
+    }
+
+    // 修改地图时每个 bucket 作为一批, 批与批之间修改地图
+    for (int lo = begin, hi; lo < end; lo = hi) {
+      hi = lo + 1;
+      while (hi < end &&
+             (edits == 0 || queries[hi].bucket == queries[lo].bucket))
+        hi++;
+      runBatch(lo, hi);
+      if (edits == 0) continue;
+      auto snapshot = MAP_VERSIONS.Current();
+      std::unordered_set<int> flipped;
+      MapChanges changes;
+      for (int k = 0; k < edits; k++) {
+        int i = rng() % GRID_MAP.Rows(), j = rng() % GRID_MAP.Cols();
+        if (endpoints.count(pack(i, j)) || !flipped.insert(pack(i, j)).second)
+          continue;
+        if (snapshot->Get(i, j))
+          changes.to_remove_obstacles.push_back({i, j});
+        else
+          changes.to_become_obstacles.push_back({i, j});
+      }
+      MAP_VERSIONS.Publish(changes);
+    }
+  }
+
+  spdlog::set_level(spdlog::level::info);
+  spdlog::info("完成 {} 个查询: 失败 {}, 代价高于最优 {}, 总扩展 {}, 总耗时 {:.1f}ms",
+               queries.size(), failed, suboptimal, total_expansions,
+               total_us / 1000);
+  if (options.path_cache_entries > 0) {
+    auto stats = PATH_CACHE.GetStats();
+    spdlog::info("寻路结果缓存: 命中 {} ({:.1f}%), 未命中 {}, 失效淘汰 {}, "
+                 "容量淘汰 {}",
+                 stats.hits, stats.HitRate() * 100, stats.misses,
+                 stats.invalidations, stats.evictions);
+  }
+  return 0;
+}
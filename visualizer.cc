@@ -6,17 +6,21 @@
 #include <spdlog/spdlog.h>
 
 #include "base.h"
+#include "map_snapshot.h"
 
 Visualizer::Visualizer(Options &options, Blackboard &b, Algorithm *algo)
     : options(options),
       blackboard(b),
       algo(algo),
       enable_screenshot(options.enable_screenshot) {
-  memset(shortest_grids, 0, sizeof(shortest_grids));
+  shortest_grids.Resize(GRID_MAP.Rows(), GRID_MAP.Cols(), false);
 }
 
 int Visualizer::Init() {
-  memset(CHANGED_GRIDS, 0, sizeof CHANGED_GRIDS);
+  CHANGED_GRIDS.Resize(GRID_MAP.Rows(), GRID_MAP.Cols(), false);
+  // 地图的修改通过快照发布, 其他线程也可以发布修改 (见 map_snapshot.h)
+  if (MAP_VERSIONS.Reset(GRID_MAP) == 0)
+    map_version = MAP_VERSIONS.Current()->Version();
 
   // 初始化 SDL
   if (SDL_Init(SDL_INIT_EVERYTHING) != 0) {
@@ -56,10 +60,11 @@ int Visualizer::Init() {
     return -1;
   }
 
-  // 创建窗口
+  // 创建窗口, 窗口尺寸由地图尺寸决定
   window = SDL_CreateWindow("shortest-path-visulization-sdl",
                             SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-                            WINDOW_WIDTH, WINDOW_HEIGHT, SDL_WINDOW_SHOWN);
+                            GRID_MAP.Cols() * GRID_SIZE,
+                            GRID_MAP.Rows() * GRID_SIZE, SDL_WINDOW_SHOWN);
   if (window == nullptr) {
     spdlog::error("无法创建窗口: {}", SDL_GetError());
     SDL_DestroyTexture(arrow_texture);
@@ -98,6 +103,14 @@ int Visualizer::Init() {
   }
   SDL_FreeSurface(ts);
 
+  // 创建持久的渲染目标, 不支持时退化为每帧全部重绘
+  canvas = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA8888,
+                             SDL_TEXTUREACCESS_TARGET,
+                             GRID_MAP.Cols() * GRID_SIZE,
+                             GRID_MAP.Rows() * GRID_SIZE);
+  if (canvas == nullptr)
+    spdlog::warn("无法创建渲染目标, 每帧将全部重绘: {}", SDL_GetError());
+
   // 计算每个箭头的宽度
   int offset = 0;
   for (int i = 0; i < 8; i++) {
@@ -112,7 +125,8 @@ int Visualizer::Init() {
 
   spdlog::info("初始化 SDL 成功");
 
-  // 初始化算法设置
+  // 初始化算法设置, 并让算法记录每一步修改的方格
+  blackboard.track_dirty = true;
   algo->Setup(blackboard, options);
 
   spdlog::info("初始化算法成功");
@@ -120,6 +134,7 @@ int Visualizer::Init() {
 }
 
 void Visualizer::Destroy() {
+  if (canvas) SDL_DestroyTexture(canvas);
   SDL_DestroyRenderer(renderer);
   SDL_DestroyWindow(window);
   SDL_DestroyTexture(arrow_texture);
@@ -155,10 +170,7 @@ void Visualizer::Start() {
       // 否则, 需要设定当前需要绘制的最短路径点
       handleShortestPathPalyStates();
     }
-    // 清理屏幕,并绘制一次
-    // 背景颜色: 白色
-    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-    SDL_RenderClear(renderer);
+    // 绘制一次
     draw();
     SDL_RenderPresent(renderer);
     if ((code == -2 || is_shortest_path_ever_rendered) && enable_screenshot) {
@@ -180,21 +192,37 @@ void Visualizer::Start() {
 }
 
 void Visualizer::handleMapChanges() {
-  for (const auto &[i, j] : to_become_obstacles) {
-    GRID_MAP[i][j] = 1;
-    CHANGED_GRIDS[i][j] ^= 1;  // 两次修改相当于没修改
+  MapChanges changes;
+  if (map_version == 0) {
+    // 分块存储的地图没有快照, 直接修改
+    changes = {to_become_obstacles, to_remove_obstacles};
+    for (const auto &[i, j] : changes.to_become_obstacles)
+      GRID_MAP.Set(i, j, 1);
+    for (const auto &[i, j] : changes.to_remove_obstacles)
+      GRID_MAP.Set(i, j, 0);
+  } else {
+    if (!to_become_obstacles.empty() || !to_remove_obstacles.empty())
+      MAP_VERSIONS.Publish({to_become_obstacles, to_remove_obstacles});
+    // 推进到最新的版本, 包括其他线程发布的修改
+    auto snapshot = MAP_VERSIONS.Current();
+    if (snapshot->Version() != map_version) {
+      MAP_VERSIONS.Sync(GRID_MAP, map_version, *snapshot, changes);
+      map_version = snapshot->Version();
+    }
   }
-  for (const auto &[i, j] : to_remove_obstacles) {
-    GRID_MAP[i][j] = 0;
+  for (const auto &[i, j] : changes.to_become_obstacles)
     CHANGED_GRIDS[i][j] ^= 1;  // 两次修改相当于没修改
-  }
-  if (to_become_obstacles.size() > 0 || to_remove_obstacles.size() > 0) {
-    algo->HandleMapChanges(blackboard, options, to_become_obstacles,
-                           to_remove_obstacles);
+  for (const auto &[i, j] : changes.to_remove_obstacles)
+    CHANGED_GRIDS[i][j] ^= 1;
+  if (!changes.Empty()) {
+    algo->HandleMapChanges(blackboard, options, changes.to_become_obstacles,
+                           changes.to_remove_obstacles);
     // 注意清理当前最短路的播放
-    memset(shortest_grids, 0, sizeof shortest_grids);
+    shortest_grids.Fill(false);
     shortest_grid_no = 0;
     is_shortest_path_ever_rendered = false;
+    // 障碍物和红色边框变了, 全部重绘
+    blackboard.dirty_all = true;
   }
   to_become_obstacles.clear();
   to_remove_obstacles.clear();
@@ -207,9 +235,10 @@ void Visualizer::handleStartPointChange() {
     new_start = {-1, -1};
     algo->HandleStartPointChange(blackboard, options);
     // 注意清理当前最短路的播放
-    memset(shortest_grids, 0, sizeof shortest_grids);
+    shortest_grids.Fill(false);
     shortest_grid_no = 0;
     is_shortest_path_ever_rendered = false;
+    blackboard.dirty_all = true;
   }
 }
 
@@ -240,8 +269,9 @@ int Visualizer::handleInputs() {
         // 单击翻转地图元素, 新增或者删除一个障碍物, 更新地图
         if (e.button.button == SDL_BUTTON_LEFT) {
           Point p{e.button.y / GRID_SIZE, e.button.x / GRID_SIZE};
+          if (!ValidatePoint(p)) break;
           int flag = 0;                       // for 日志
-          if (GRID_MAP[p.first][p.second]) {  // 消除障碍物
+          if (GRID_MAP.Get(p.first, p.second)) {  // 消除障碍物
             to_remove_obstacles.push_back(p);
           } else {  // 新增障碍物
             to_become_obstacles.push_back(p);
@@ -252,7 +282,7 @@ int Visualizer::handleInputs() {
         }
         if (e.button.button == SDL_BUTTON_RIGHT) {
           Point p{e.button.y / GRID_SIZE, e.button.x / GRID_SIZE};
-          if (p != options.start) {
+          if (ValidatePoint(p) && p != options.start) {
             spdlog::info("监听到鼠标右键点击 {},{}, 变更起始点", p.first,
                          p.second);
             new_start = p;
@@ -265,53 +295,72 @@ int Visualizer::handleInputs() {
 }
 
 void Visualizer::draw() {
-  // 绘制方格 (x,y) 表示绘制坐标, (i, j) 表示方格坐标
-  for (int i = 0, y = 0; i < M; i++, y += GRID_SIZE) {
-    for (int j = 0, x = 0; j < N; j++, x += GRID_SIZE) {
-      // 正方形 rect, 内侧是 inner (边框宽度 1)
-      SDL_Rect rect = {x, y, GRID_SIZE, GRID_SIZE};
-      SDL_Rect inner = {x + 1, y + 1, GRID_SIZE - 2, GRID_SIZE - 2};
-      // 绘制外层正方形, 边框是黑色
-      SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
-      // 对于修改过的正方形, 边框是红色
-      if (CHANGED_GRIDS[i][j]) SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
-      SDL_RenderDrawRect(renderer, &rect);
-      // 选用内层正方形的填充颜色
-      if (GRID_MAP[i][j] == 1)
-        // 障碍物: 灰色
-        SDL_SetRenderDrawColor(renderer, 64, 64, 64, 255);
-      else if ((i == options.start.first && j == options.start.second) ||
-               (i == options.target.first && j == options.target.second))
-        // 起始点: 绿色
-        SDL_SetRenderDrawColor(renderer, 0, 255, 0, 255);
-      else if (shortest_grids[i][j])
-        // 最短路径点: 绿色
-        SDL_SetRenderDrawColor(renderer, 0, 255, 0, 255);
-      else if (blackboard.visited[i][j])
-        // 访问过的路径点: 蓝色
-        SDL_SetRenderDrawColor(renderer, 0, 150, 255, 255);
-      else if (blackboard.exploring[i][j] >= 0)
-        // 将要扩展的点: 浅蓝色
-        SDL_SetRenderDrawColor(renderer, 173, 216, 230, 255);
-      else
-        // 默认是白色
-        SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
-      // 绘制内侧正方形
-      SDL_RenderFillRect(renderer, &inner);
-      // 如果支持流场箭头展示. 背景色不变, 黑色字体
-      if (blackboard.isSupportedFlowField) {
-        auto flow = blackboard.flows[i][j];
-        if (0 <= flow && flow < 8) {
-          // 方格的中心位置
-          int x1 = x + GRID_SIZE / 2, y1 = y + GRID_SIZE / 2;
-          // 获取字符宽度 和 宽度
-          int w = arrow_w[flow], h = arrow_h, offset = arrow_offset[flow];
-          SDL_Rect dst = {x1 - w / 2, y1 - h / 2, w, h};
-          SDL_Rect src = {offset, 0, w, h};
-          // 目标位置
-          SDL_RenderCopy(renderer, arrow_texture, &src, &dst);
-        }
-      }
+  if (canvas) SDL_SetRenderTarget(renderer, canvas);
+  // 修改的方格太多时, 全部重绘更快
+  if (canvas == nullptr || blackboard.dirty_all ||
+      static_cast<int>(blackboard.dirty.size()) > GRID_MAP.Size() / 2) {
+    // 背景颜色: 白色
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+    SDL_RenderClear(renderer);
+    for (int i = 0; i < GRID_MAP.Rows(); i++)
+      for (int j = 0; j < GRID_MAP.Cols(); j++) drawGrid(i, j);
+  } else {
+    // 只重绘脏方格, 其余的方格保留上一帧的画面
+    for (auto x : blackboard.dirty) drawGrid(unpack_i(x), unpack_j(x));
+  }
+  blackboard.dirty.clear();
+  blackboard.dirty_all = false;
+  if (canvas) {
+    SDL_SetRenderTarget(renderer, nullptr);
+    SDL_RenderCopy(renderer, canvas, nullptr, nullptr);
+  }
+}
+
+void Visualizer::drawGrid(int i, int j) {
+  // (x,y) 表示绘制坐标, (i, j) 表示方格坐标
+  int x = j * GRID_SIZE, y = i * GRID_SIZE;
+  // 正方形 rect, 内侧是 inner (边框宽度 1)
+  SDL_Rect rect = {x, y, GRID_SIZE, GRID_SIZE};
+  SDL_Rect inner = {x + 1, y + 1, GRID_SIZE - 2, GRID_SIZE - 2};
+  // 绘制外层正方形, 边框是黑色
+  SDL_SetRenderDrawColor(renderer, 0, 0, 0, 255);
+  // 对于修改过的正方形, 边框是红色
+  if (CHANGED_GRIDS[i][j]) SDL_SetRenderDrawColor(renderer, 255, 0, 0, 255);
+  SDL_RenderDrawRect(renderer, &rect);
+  // 选用内层正方形的填充颜色
+  if (GRID_MAP.Get(i, j))
+    // 障碍物: 灰色
+    SDL_SetRenderDrawColor(renderer, 64, 64, 64, 255);
+  else if ((i == options.start.first && j == options.start.second) ||
+           (i == options.target.first && j == options.target.second))
+    // 起始点: 绿色
+    SDL_SetRenderDrawColor(renderer, 0, 255, 0, 255);
+  else if (shortest_grids[i][j])
+    // 最短路径点: 绿色
+    SDL_SetRenderDrawColor(renderer, 0, 255, 0, 255);
+  else if (blackboard.visited[i][j])
+    // 访问过的路径点: 蓝色
+    SDL_SetRenderDrawColor(renderer, 0, 150, 255, 255);
+  else if (blackboard.exploring[i][j] >= 0)
+    // 将要扩展的点: 浅蓝色
+    SDL_SetRenderDrawColor(renderer, 173, 216, 230, 255);
+  else
+    // 默认是白色
+    SDL_SetRenderDrawColor(renderer, 255, 255, 255, 255);
+  // 绘制内侧正方形
+  SDL_RenderFillRect(renderer, &inner);
+  // 如果支持流场箭头展示. 背景色不变, 黑色字体
+  if (blackboard.isSupportedFlowField && blackboard.flows) {
+    auto flow = (*blackboard.flows)[i][j];
+    if (0 <= flow && flow < 8) {
+      // 方格的中心位置
+      int x1 = x + GRID_SIZE / 2, y1 = y + GRID_SIZE / 2;
+      // 获取字符宽度 和 宽度
+      int w = arrow_w[flow], h = arrow_h, offset = arrow_offset[flow];
+      SDL_Rect dst = {x1 - w / 2, y1 - h / 2, w, h};
+      SDL_Rect src = {offset, 0, w, h};
+      // 目标位置
+      SDL_RenderCopy(renderer, arrow_texture, &src, &dst);
     }
   }
 }
@@ -319,15 +368,18 @@ void Visualizer::draw() {
 void Visualizer::handleShortestPathPalyStates() {
   if (blackboard.path.empty()) return;
   // 播放到下一个路径点, 到尾部则循环
-  if (shortest_grid_no == blackboard.path.size() - 1) {
+  if (shortest_grid_no == static_cast<int>(blackboard.path.size()) - 1) {
     shortest_grid_no = 0;
-    memset(shortest_grids, 0, sizeof shortest_grids);
+    shortest_grids.Fill(false);
     is_shortest_path_ever_rendered = true;
+    // 路径上的方格都恢复了原来的颜色
+    for (const auto &p : blackboard.path) blackboard.MarkDirty(pack(p));
   } else {
     shortest_grid_no++;
   }
   auto &p = blackboard.path[shortest_grid_no];
   shortest_grids[p.first][p.second] = true;
+  blackboard.MarkDirty(pack(p));
 }
 
 void Visualizer::saveScreenShot() {
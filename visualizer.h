@@ -23,8 +23,11 @@ class Visualizer {
  protected:
   // 保存一次屏幕截图
   void saveScreenShot();
-  // 绘制一帧的情况
+  // 绘制一帧的情况: 在 canvas 上只重绘脏方格 (见 Blackboard::dirty),
+  // 再整体拷贝到窗口
   void draw();
+  // 绘制一个方格
+  void drawGrid(int i, int j);
   // 处理输入, 返回 -1 表示要退出
   int handleInputs();
   // 处理最短路径结果的播放状态
@@ -47,6 +50,8 @@ class Visualizer {
   TTF_Font *arrow_font = nullptr;
   // 箭头的 texture
   SDL_Texture *arrow_texture;
+  // 持久的渲染目标, 保留上一帧的画面. 创建失败时是 nullptr, 每帧全部重绘
+  SDL_Texture *canvas = nullptr;
   // 渲染时每个箭头字符的宽度 和 offset
   int arrow_w[8];
   int arrow_offset[8];
@@ -56,13 +61,15 @@ class Visualizer {
   int seq = 0;
   // 绘制最短路时的临时状态
   // shortest_grids[i][j] 是 true 表示 (i,j) 是最短路结果的一员
-  bool shortest_grids[M][N];
+  Grid<unsigned char> shortest_grids;
   // 当前播放到第几个最短路点?
   int shortest_grid_no = 0;
   // 第一次绘制完毕最短路后变为 true
   bool is_shortest_path_ever_rendered = false;
   // 需要新增成为障碍物的坐标点
   std::vector<Point> to_become_obstacles, to_remove_obstacles;
+  // GRID_MAP 当前对应的快照版本 (见 map_snapshot.h), 分块存储的地图是 0
+  uint64_t map_version = 0;
   // 将变更到的起始点
   Point new_start = {-1, -1};
 };